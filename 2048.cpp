@@ -1,27 +1,46 @@
+#include "lib2048assets.hpp"
 #include "lib2048core.hpp"
+#include "lib2048export.hpp"
+#include "lib2048pacing.hpp"
+#include "lib2048render.hpp"
+#include "lib2048save.hpp"
+#include "lib2048text.hpp"
 #include "lib2048ui.hpp"
 #include "lib2048utils.hpp"
+#include "lib2048watch.hpp"
 #include <SFML/Audio.hpp>
 #include <SFML/Graphics.hpp>
 #include <algorithm>
 #include <array>
+#include <cerrno>
+#include <chrono>
 #include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <future>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
-int cellOutlineThickness = 1;
 float scanWidthMultiplier = 0.5;
 int scanTimeMsec = 100;
 int notificationTimeMsec = 2000;
+std::string savePath = "./autosave.2048";
 int cooldownMsec = 5000;
 bool hasGameKeyPressed = true;
 bool muted = false;
 bool paused = false;
 bool hasActionKeyPressed = true;
-CyclingValues allowedFPS{{0, 60, 120, 240, 480}, 1};
-CyclingValues allowedBoardSizes({4, 8, 16}, 0);
+// frame rate while animating, 0 following the display refresh
+CyclingValues allowedFPS{{0, 60, 120, 240, 480}, 2};
+unsigned int refreshRate = 60;
+int pacingReportMsec = 5000;
+CyclingValues<gameSize> allowedBoardSizes(GAME_SIZES);
 
 std::unordered_map<sf::Keyboard::Key, gameAction> ACTIONS{
     std::make_pair(sf::Keyboard::M, gameAction::Mute),
@@ -37,11 +56,6 @@ std::unordered_map<sf::Keyboard::Key, gameMovement> MOVEMENTS{
     std::make_pair(sf::Keyboard::Left, gameMovement::Left),
     std::make_pair(sf::Keyboard::R, gameMovement::META_Restart)};
 
-std::unordered_map<gameValue, sf::Texture> cellTextures;
-std::pair<gameValue, sf::Texture> scoreTexture =
-    std::make_pair(-1, sf::Texture());
-std::pair<std::string_view, sf::Texture> pausingScreen;
-
 sf::Clock globalClock;
 sf::Time lastNotificationTime;
 std::string notification;
@@ -49,151 +63,155 @@ sf::Time lastKeyPressedTime;
 gameMovement lastMovement = gameMovement::Up;
 sf::Time lastGeneratingKeyPressedTime, lastPause;
 sf::Time previousFrameTime, currentFrameTime;
+// fonts, sounds and the streamed music read from the mapped bundle, which
+// therefore has to be destroyed after all of them
+assetBundle assets;
 sf::Font robotoMono, montserratRegular, latoBold;
-sf::Sound keyClicked;
-sf::SoundBuffer _keyClicked;
-sf::Sound keyClickedFail;
-sf::SoundBuffer _keyClickedFail;
-sf::Sound cooldownGenerated;
-sf::SoundBuffer _cooldownGenerated;
-sf::Music backgroundMusic;
+// creating any of these opens the audio device, not wanted when exporting
+struct gameAudio {
+    sf::SoundBuffer _keyClicked, _keyClickedFail, _cooldownGenerated;
+    sf::Sound keyClicked, keyClickedFail, cooldownGenerated;
+    sf::Music backgroundMusic;
+};
+std::unique_ptr<gameAudio> audio;
 gameConfig config;
+std::unique_ptr<fileWatcher> colorWatcher;
+glyphAtlas glyphs;
+std::future<void> audioLoading;
+bool audioReady = false;
+
+#ifdef EMBED_ASSETS
+extern const unsigned char embeddedAssets[];
+extern const std::size_t embeddedAssetsSize;
+#endif
+
+void initializeGlobals(bool withAudio) {
+#ifdef EMBED_ASSETS
+    bool bundled = assets.attach(embeddedAssets, embeddedAssetsSize);
+#else
+    bool bundled = assets.open("./assets.bundle");
+#endif
+    if (!bundled)
+        std::cerr << "cannot open the asset bundle, looking for the assets "
+                     "in the working directory instead\n";
+
+    // resolve every asset up front, the loaders below only touch memory
+    auto fontData = std::array{assets.get("RobotoMono-Regular.ttf"),
+                               assets.get("Montserrat-Regular.ttf"),
+                               assets.get("Lato-Bold.ttf")};
+    auto soundData = std::array{assets.get("soft-hitsoft.wav"),
+                                assets.get("sectionfail.wav"),
+                                assets.get("sectionpass.wav")};
+    auto musicData = assets.get("pause-loop.wav");
+
+    // audio is not needed for the first frame, it is attached once decoded
+    if (withAudio) {
+        audio = std::make_unique<gameAudio>();
+        audioLoading = std::async(std::launch::async, [soundData, musicData]() {
+            auto load = [](sf::SoundBuffer &buffer, assetData data) {
+                return std::async(std::launch::async, [&buffer, data]() {
+                    buffer.loadFromMemory(data.data(), data.size());
+                });
+            };
+            auto sounds =
+                std::array{load(audio->_keyClicked, soundData[0]),
+                           load(audio->_keyClickedFail, soundData[1]),
+                           load(audio->_cooldownGenerated, soundData[2])};
+            audio->backgroundMusic.openFromMemory(musicData.data(),
+                                                  musicData.size());
+            for (auto &sound : sounds)
+                sound.wait();
+        });
+    }
+
+    auto fonts = std::array{&robotoMono, &montserratRegular, &latoBold};
+    std::vector<std::future<bool>> fontLoading;
+    for (std::size_t i = 0; i < fonts.size(); i++)
+        fontLoading.push_back(
+            std::async(std::launch::async, [font = fonts[i], &fontData, i]() {
+                return font->loadFromMemory(fontData[i].data(),
+                                            fontData[i].size());
+            }));
+
+    for (auto &font : fontLoading)
+        font.wait();
 
-void initializeGlobals() {
-    robotoMono.loadFromFile("./RobotoMono-Regular.ttf");
-    montserratRegular.loadFromFile("./Montserrat-Regular.ttf");
-    latoBold.loadFromFile("./Lato-Bold.ttf");
-    _keyClicked.loadFromFile("./soft-hitsoft.wav");
-    _keyClickedFail.loadFromFile("./sectionfail.wav");
-    _cooldownGenerated.loadFromFile("./sectionpass.wav");
-    keyClicked = sf::Sound(_keyClicked);
-    keyClickedFail = sf::Sound(_keyClickedFail);
-    cooldownGenerated = sf::Sound(_cooldownGenerated);
-    backgroundMusic.openFromFile("./pause-loop.wav");
-    backgroundMusic.setVolume(50);
+    // text drawn every frame, the tiles and overlay are cached by tileAtlas
+    glyphs.build({{&latoBold, 40, DIGITS}, {&robotoMono, 14, PRINTABLE_ASCII}});
 
     previousFrameTime = globalClock.getElapsedTime();
+}
 
-    // color configuration
-    config.setup();
+/**
+ * Hook the decoded sounds up once the background loading is done.
+ */
+bool attachAudio() {
+    if (audioReady)
+        return true;
+    if (!audio || audioLoading.wait_for(std::chrono::seconds(0)) !=
+        std::future_status::ready)
+        return false;
+    audio->keyClicked = sf::Sound(audio->_keyClicked);
+    audio->keyClickedFail = sf::Sound(audio->_keyClickedFail);
+    audio->cooldownGenerated = sf::Sound(audio->_cooldownGenerated);
+    audio->backgroundMusic.setVolume(50);
+    std::cout << "Audio ready after "
+              << globalClock.getElapsedTime().asMilliseconds() << " ms\n";
+    return audioReady = true;
+}
+
+/**
+ * Re-read the colour tables from the working directory, returning the tiles
+ * whose colours changed. A missing, empty or malformed table keeps the
+ * current palette.
+ */
+std::bitset<64> reloadColors() {
+    auto read = [](const char *path) {
+        std::ifstream file(path);
+        if (!file)
+            throw std::invalid_argument(std::string("cannot open ") + path);
+        return std::string(std::istreambuf_iterator<char>(file),
+                           std::istreambuf_iterator<char>());
+    };
+    auto empty = [](const colorTable &table) {
+        return std::none_of(table.begin(), table.end(),
+                            [](const paletteEntry &entry) {
+                                return entry.present;
+                            });
+    };
+    auto reloaded = config;
+    try {
+        reloaded.setup(read("./color.txt"), read("./color2.txt"));
+        if (empty(reloaded.cellColors) || empty(reloaded.textColors))
+            throw std::invalid_argument("a colour table has no entries");
+    } catch (const std::invalid_argument &error) {
+        notification = std::string("Cannot reload colors: ") + error.what();
+        lastNotificationTime = globalClock.getElapsedTime();
+        return {};
+    }
+    auto changed = reloaded.difference(config);
+    config = reloaded;
+    notification = "Reloaded colors of " + std::to_string(changed.count()) +
+                   " tile(s).";
+    lastNotificationTime = globalClock.getElapsedTime();
+    return changed;
 }
 
 std::string_view LOST_STRING{"LOST"};
 std::string_view PAUSED_STRING{"PAUSED"};
 
-constexpr auto getGameStatusString(const gameState &game) {
+auto getGameStatusString(const gameState &game) {
     if (game.lost) {
         return LOST_STRING;
     } else {
         return PAUSED_STRING;
     }
 }
-void renderPausingScreen(sf::Vector2f windowSize, gameState game) {
-    sf::RenderTexture pausingScreenTexture;
-    pausingScreenTexture.create(windowSize.x, windowSize.y);
-    pausingScreenTexture.clear(sf::Color::Transparent);
-    sf::RectangleShape _;
-    _.setSize(sf::Vector2f(windowSize));
-    _.setFillColor(sf::Color(0xFF, 0xFF, 0xFF, 230));
-    _.setPosition(0, 0);
-
-    sf::Text pausedText(std::string(getGameStatusString(game)), latoBold, 50);
-    auto textBoundaryBox = pausedText.getGlobalBounds();
-    pausedText.setPosition(windowSize.x / 2 - textBoundaryBox.width / 2,
-                           windowSize.y / 2 - textBoundaryBox.height / 2);
-    pausedText.setFillColor(sf::Color::Black);
-
-    pausingScreenTexture.draw(_);
-    pausingScreenTexture.draw(pausedText);
-    pausingScreenTexture.display();
-    pausingScreen = std::make_pair(getGameStatusString(game),
-                                   pausingScreenTexture.getTexture());
-}
-
-sf::Color getCellColor(gameValue value) {
-    sf::Color _;
-    if (config.cellColorMapping.count(value))
-        _ = config.cellColorMapping[value];
-    else
-        _ = sf::Color(0xFF, 0xFF, 0xFF, 160);
-    if (value)
-        _.a = 180 + (uint8_t)((log2(value) / log2(2048)) * 75);
-    return _;
-}
-
-sf::Color getTextColor(gameValue value) {
-    if (config.cellColorMapping.count(value))
-        return config.textColorMapping[value];
-    return sf::Color(0, 0, 0);
-}
-
-sf::Texture renderCell(gameValue value, unsigned int cellSide, float fontSize) {
-    if (cellTextures.count(value))
-        return cellTextures[value];
-
-    sf::RenderTexture cell;
-    unsigned int renderCellSide = cellSide + cellOutlineThickness * 2;
-    cell.create(renderCellSide, renderCellSide);
-    cell.clear();
-
-    sf::RectangleShape box;
-    box.setPosition(0 + cellOutlineThickness,
-                    0 + cellOutlineThickness); // the outline seems to be drawn
-                                               // around the box itself, and not
-                                               // counted in the main rectangle
-    box.setOutlineColor(sf::Color(255, 255, 255, 255));
-    box.setOutlineThickness(cellOutlineThickness);
-    box.setSize(sf::Vector2f(cellSide, cellSide));
-    box.setFillColor(getCellColor(value));
-    cell.draw(box);
-
-    // render the text
-    sf::Text text(value ? std::to_string(value) : "", montserratRegular,
-                  fontSize);
-    auto textBoundaryBox = text.getGlobalBounds();
-    // place the number in the center
-    text.setOrigin(
-        (textBoundaryBox.width - cellSide) / 2 + textBoundaryBox.left,
-        (textBoundaryBox.height - cellSide) / 2 + textBoundaryBox.top);
-    text.setFillColor(getTextColor(value));
-
-    cell.draw(text);
-    cell.display();
-
-    return cellTextures[value] = cell.getTexture();
-}
-
-sf::Texture renderScore(gameValue score, unsigned int width,
-                        unsigned int height) {
-    if (score == scoreTexture.first)
-        return scoreTexture.second;
-
-    sf::RenderTexture _score;
-    _score.create(width + cellOutlineThickness * 2,
-                  height + cellOutlineThickness * 2);
-    _score.clear(sf::Color::Transparent);
-
-    sf::RectangleShape box;
-    box.setPosition(0 + cellOutlineThickness, 0 + cellOutlineThickness);
-    box.setOutlineColor(sf::Color::Black);
-    box.setOutlineThickness(cellOutlineThickness);
-    box.setSize(sf::Vector2f(width, height));
-    box.setFillColor(sf::Color::Transparent);
-    _score.draw(box);
-
-    // render the text
-    sf::Text text(std::to_string(score), latoBold, 40);
-    auto textBoundaryBox = text.getGlobalBounds();
-    text.setOrigin((textBoundaryBox.width - width) / 2 + textBoundaryBox.left,
-                   (textBoundaryBox.height - height) / 2 + textBoundaryBox.top);
-    text.setFillColor(sf::Color::Black);
-
-    _score.draw(text);
-    _score.display();
-
-    scoreTexture = std::make_pair(score, _score.getTexture());
-
-    return _score.getTexture();
+gameValue getHighestValue(const gameState &game) {
+    gameValue highest = 0;
+    for (const auto &row : game.matrix)
+        highest = std::max(highest, *std::max_element(row.begin(), row.end()));
+    return highest;
 }
 
 void entry() {
@@ -203,22 +221,59 @@ void entry() {
         sf::VideoMode(desktopMode.width * 4 / 5, desktopMode.height * 4 / 5),
         "2048");
 
-    gameState game(allowedBoardSizes.current());
-    game.initialize();
+    // pick up where the last session left off
+    auto saved = loadSnapshot(savePath);
+    bool resumed = saved && allowedBoardSizes.select(saved->size);
+    gameState game = resumed ? gameState(*saved)
+                             : gameState(allowedBoardSizes.current());
+    if (resumed) {
+        notification = "Resumed the last game.";
+        lastNotificationTime = globalClock.getElapsedTime();
+    } else
+        game.initialize();
+
+    // snapshots are written off the render loop, see autosaver
+    autosaver saver(savePath);
+    bool gameChanged = false;
 
     bool hasFocus = true;
 
-    // don't overload machines
-    window.setFramerateLimit(120);
+    // don't overload machines, see framePacer
+    framePacer pacer(refreshRate);
+    pacer.setCap(allowedFPS.current());
+    auto demand = frameDemand::Interactive;
+    sf::Time lastPacingReport;
     window.setTitle("2048");
 
-    sf::Sound(_keyClicked).play();
-    renderPausingScreen(sf::Vector2f(window.getSize()), game);
+    tileAtlas atlas(config, latoBold, montserratRegular,
+                    assets.get("Lato-Bold.ttf"),
+                    assets.get("Montserrat-Regular.ttf"));
+    bool firstFrame = true;
+    auto rebuildAtlas = [&atlas, &window, &game]() {
+        atlas.rebuild({sceneLayout(window.getSize(), game.matrix.size()),
+                       config, getHighestValue(game),
+                       getGameStatusString(game)});
+    };
+    textLine scoreText(glyphs, latoBold, 40), notify(glyphs, robotoMono, 14);
 
     while (window.isOpen()) {
         sf::Event event;
 
+        // animations sample the clock right at the frame deadline
+        pacer.wait(demand);
         auto currentTime = globalClock.getElapsedTime();
+        if (currentTime - lastPacingReport >=
+            sf::milliseconds(pacingReportMsec)) {
+            auto report = pacer.collect();
+            if (report.missed)
+                std::cout << "Missed " << report.missed << " of "
+                          << report.frames << " frame deadlines, up to "
+                          << std::chrono::duration<float, std::milli>(
+                                 report.worstLateness)
+                                 .count()
+                          << " ms late\n";
+            lastPacingReport = currentTime;
+        }
         bool slowDown = true;
 
         while (window.pollEvent(event)) {
@@ -230,34 +285,38 @@ void entry() {
                 hasFocus = false;
                 paused = true;
             };
+
+            /**
+             * Resize the view port should the window get resized. Textures
+             * are rebuilt in the background, the current ones get scaled
+             * until then.
+             */
+            if (event.type == sf::Event::Resized) {
+                notification = std::string("Resizing viewport ") + "to " +
+                               std::to_string(event.size.width) + " " +
+                               std::to_string(event.size.height);
+                lastNotificationTime = currentTime;
+                window.setView(sf::View(
+                    sf::FloatRect(0, 0, event.size.width, event.size.height)));
+                rebuildAtlas();
+            }
         };
 
-        /**
-         * Resize the view port should the window get resized
-         */
-        if (event.type == sf::Event::Resized) {
-            notification = std::string("Resizing viewport ") + "to " +
-                           std::to_string(event.size.width) + " " +
-                           std::to_string(event.size.height);
-            lastNotificationTime = currentTime;
-            window.setView(sf::View(
-                sf::FloatRect(0, 0, event.size.width, event.size.height)));
-            cellTextures.clear();
-            scoreTexture = std::make_pair(-1, sf::Texture());
-            renderPausingScreen(sf::Vector2f(window.getSize()), game);
-        }
         window.clear(sf::Color(0xd6d5d200));
         auto windowSize = window.getSize();
-
-        if (pausingScreen.first != getGameStatusString(game))
-            renderPausingScreen(sf::Vector2f(window.getSize()), game);
-
-        backgroundMusic.setLoop(true);
-        if (backgroundMusic.getStatus() != sf::SoundSource::Status::Playing)
-            backgroundMusic.play();
-        backgroundMusic.setVolume((muted || paused) ? 0 : 100);
-        keyClicked.setVolume((muted || paused) ? 0 : 100);
-        keyClickedFail.setVolume((muted || paused) ? 0 : 100);
+        atlas.poll();
+        if (colorWatcher && !colorWatcher->poll().empty())
+            atlas.invalidate(reloadColors());
+
+        if (attachAudio()) {
+            audio->backgroundMusic.setLoop(true);
+            if (audio->backgroundMusic.getStatus() !=
+                sf::SoundSource::Status::Playing)
+                audio->backgroundMusic.play();
+            audio->backgroundMusic.setVolume((muted || paused) ? 0 : 100);
+            audio->keyClicked.setVolume((muted || paused) ? 0 : 100);
+            audio->keyClickedFail.setVolume((muted || paused) ? 0 : 100);
+        }
 
         if (hasFocus) {
             /**
@@ -284,23 +343,26 @@ void entry() {
                 }
                 case gameAction::Lose: {
                     game.lost = !game.lost;
+                    gameChanged = true;
                     slowDown = false;
                     break;
                 }
                 case gameAction::ResizeGame: {
-                    cellTextures.clear();
                     game = gameState(allowedBoardSizes.advance());
                     game.initialize();
+                    gameChanged = true;
+                    rebuildAtlas();
                     slowDown = false;
                     lastGeneratingKeyPressedTime = currentTime;
                     break;
                 }
                 case gameAction::CycleFPS: {
                     auto fps = allowedFPS.advance();
-                    window.setFramerateLimit(fps);
-                    notification =
-                        "Setting framerate limit to " +
-                        (fps ? std::to_string(fps) + "FPS" : "unlimited") + ".";
+                    pacer.setCap(fps);
+                    notification = "Setting framerate limit to " +
+                                   (fps ? std::to_string(fps) + "FPS"
+                                        : "the display refresh rate") +
+                                   ".";
                     lastNotificationTime = currentTime;
                     slowDown = false;
                 }
@@ -322,13 +384,16 @@ void entry() {
                 if (!paused) {
                     slowDown = false;
                     auto changed = game.handleMove(move);
+                    gameChanged = gameChanged ||
+                                  changed.changedByUserInteraction ||
+                                  changed.generated;
 
                     if (changed.changedByUserInteraction) {
-                        keyClicked.play();
+                        audio->keyClicked.play();
                         lastKeyPressedTime = currentTime;
                         lastMovement = move;
                     } else
-                        keyClickedFail.play();
+                        audio->keyClickedFail.play();
                     if (changed.generated)
                         lastGeneratingKeyPressedTime = currentTime;
                 }
@@ -336,6 +401,11 @@ void entry() {
             hasGameKeyPressed = __validKey;
         }
 
+        if (gameChanged) {
+            saver.submit(game.snapshot());
+            gameChanged = false;
+        }
+
         auto lastKeyElapsedMsec =
             currentTime.asMilliseconds() - lastKeyPressedTime.asMilliseconds();
         auto paddedScanTimeMsec = (1 + scanWidthMultiplier) * scanTimeMsec;
@@ -348,13 +418,18 @@ void entry() {
             // has key animation ?
             && !(lastKeyPressedTime.asMilliseconds() &&
                  lastKeyElapsedMsec < paddedScanTimeMsec) &&
-            (paused || game.lost) && !hasFocus)
+            (paused || game.lost) && !hasFocus) {
+            demand = frameDemand::Background;
             continue;
+        }
 
+        bool scanning = lastKeyPressedTime.asMilliseconds() &&
+                        lastKeyElapsedMsec < paddedScanTimeMsec;
+        sceneLayout layout(windowSize, game.matrix.size());
         if (paused || game.lost) {
             if (!lastPause.asMilliseconds())
                 lastPause = currentTime;
-            window.draw(sf::Sprite(pausingScreen.second));
+            window.draw(atlas.overlay(getGameStatusString(game), layout));
         } else {
             auto pausedMsec =
                 lastPause.asMilliseconds()
@@ -366,124 +441,28 @@ void entry() {
             auto diff = currentTime.asMilliseconds() -
                         lastGeneratingKeyPressedTime.asMilliseconds();
             if (cooldownMsec > diff) {
-                auto height =
-                    float(windowSize.y) * (cooldownMsec - diff) / cooldownMsec;
-                sf::RectangleShape cooldown(sf::Vector2f(windowSize.x, height));
-                auto fill = sf::Color::White;
-                fill.a = 103;
-                cooldown.setFillColor(fill);
-                cooldown.setPosition(0, windowSize.y - height);
-                window.draw(cooldown);
+                drawCooldown(window, layout,
+                             float(cooldownMsec - diff) / cooldownMsec);
             } else {
                 if (game.handleMove(gameMovement::META_RandomlyGenerate)
                         .generated) {
+                    gameChanged = true;
                     lastGeneratingKeyPressedTime = currentTime;
-                    cooldownGenerated.play();
+                    audio->cooldownGenerated.play();
                 }
             }
 
-            /**
-             * Game field
-             *
-             * The game field will be centered in the window horizontally.
-             * Width and height should be 75% of the window width/height.
-             * Should they be different, the minimum of two will be used.
-             */
-            auto &matrix = game.matrix;
-            unsigned int baseDimension = std::min(windowSize.x, windowSize.y),
-                         matrixSide = baseDimension / 4 * 3;
-            unsigned int baseX = (windowSize.x - matrixSide) >> 1,
-                         baseY = (windowSize.y - matrixSide) >> 1,
-                         cellSide = matrixSide / matrix[0].size(),
-                         borderSize = cellSide / 8;
-            cellSide -= borderSize;
-            for (gameSize rowIndex = 0; rowIndex < matrix.size(); rowIndex++)
-                for (gameSize cellIndex = 0;
-                     cellIndex < matrix[rowIndex].size(); cellIndex++) {
-                    auto cell = renderCell(matrix[rowIndex][cellIndex],
-                                           cellSide, float(cellSide) / 2.5);
-                    sf::Sprite cellSprite(cell);
-                    auto renderCellSide = cell.getSize().x;
-                    cellSprite.setPosition(
-                        baseX + cellIndex * (renderCellSide + borderSize),
-                        baseY + rowIndex * (renderCellSide + borderSize));
-                    window.draw(cellSprite);
-                }
+            drawBoard(window, atlas, game, layout);
 
-            if (lastKeyPressedTime.asMilliseconds() &&
-                lastKeyElapsedMsec < paddedScanTimeMsec) {
-                auto scanCoverage =
-                    (cellSide + cellOutlineThickness * 2) * matrix.size() +
-                    (matrix.size() - 1) * borderSize;
-                auto scanWidth = scanCoverage * scanWidthMultiplier;
-                bool increment = true;
-                gameSize from = 0, to = scanWidth;
-                auto progress =
-                    float(scanTimeMsec - lastKeyElapsedMsec) / scanTimeMsec;
-                switch (lastMovement) {
-                case gameMovement::Down:
-                case gameMovement::Right:
-                    increment = false;
-                    from = scanWidth, to = 0;
-                    progress = 1 - progress;
-                    [[fallthrough]];
-                case gameMovement::Up:
-                case gameMovement::Left: {
-                    for (auto i = from; (from > to ? i > to : i < to);
-                         increment ? i++ : i--) {
-                        auto y = baseY + progress * matrixSide +
-                                 (matrixSide / 2) - scanWidth + 1 + i;
-                        auto x = baseX + progress * matrixSide +
-                                 (matrixSide / 2) - scanWidth + 1 + i;
-                        sf::RectangleShape scan;
-                        auto c = sf::Color::White;
-                        const int maximumAlpha = 128;
-                        if (lastMovement == gameMovement::Up ||
-                            lastMovement == gameMovement::Down) {
-                            if (y < baseY || y > baseY + scanCoverage)
-                                continue;
-                            scan.setSize(sf::Vector2f(scanCoverage, 1));
-                            scan.setPosition(baseX, y);
-                            c.a = maximumAlpha *
-                                  ((lastMovement == gameMovement::Up
-                                        ? 1 - float(i + 1)
-                                        : float(i + 1)) /
-                                   scanWidth);
-                        }
-
-                        if (lastMovement == gameMovement::Left ||
-                            lastMovement == gameMovement::Right) {
-                            if (x < baseX || x > baseX + scanCoverage)
-                                continue;
-                            scan.setSize(sf::Vector2f(1, scanCoverage));
-                            scan.setPosition(x, baseY);
-                            c.a = maximumAlpha *
-                                  ((lastMovement == gameMovement::Left
-                                        ? 1 - float(i + 1)
-                                        : float(i + 1)) /
-                                   scanWidth);
-                        }
-
-                        scan.setFillColor(c);
-                        window.draw(scan);
-                    }
-                }
-                default:
-                    break;
-                };
-            }
+            if (scanning)
+                drawScan(window, layout, lastMovement, lastKeyElapsedMsec,
+                         scanTimeMsec, scanWidthMultiplier);
         }
 
         /**
          * Score
          */
-        auto __ = renderScore(game.score, windowSize.x / 10 * 2,
-                              windowSize.y / 20 * 2);
-        sf::Sprite score(__);
-        score.setPosition(windowSize.x / 2 - score.getGlobalBounds().width / 2,
-                          windowSize.y / 15 -
-                              score.getGlobalBounds().height / 2);
-        window.draw(score);
+        drawScore(window, scoreText, game.score, layout);
 
         /**
          * Notification
@@ -493,7 +472,7 @@ void entry() {
                   lastNotificationTime.asMilliseconds()) /
             notificationTimeMsec;
         if (notifyAppearancePercentage <= 1) {
-            sf::Text notify(notification, robotoMono, 14);
+            notify.setString(notification);
             notify.setPosition(std::min<unsigned int>(windowSize.x / 100, 5),
                                std::min<unsigned int>(windowSize.y / 100, 5));
             auto notifyColor = sf::Color::Black;
@@ -502,11 +481,206 @@ void entry() {
             window.draw(notify);
         }
 
+        // the cooldown bar creeps slowly enough for the interactive rate
+        if ((scanning && !paused && !game.lost) ||
+            notifyAppearancePercentage <= 1)
+            demand = frameDemand::Animating;
+        else
+            demand = hasFocus ? frameDemand::Interactive
+                              : frameDemand::Background;
+
         window.display();
+
+        if (firstFrame) {
+            std::cout << "Cold start: first frame after "
+                      << globalClock.getElapsedTime().asMilliseconds()
+                      << " ms\n";
+            firstFrame = false;
+        }
+    }
+}
+
+struct exportOptions {
+    std::string replay, output = "-";
+    unsigned int width = 1280, height = 720, fps = 60;
+    int moveIntervalMsec = 150;
+};
+
+/**
+ * Render a replay offscreen as raw RGBA frames, ready to be piped into an
+ * encoder:
+ *
+ *   2048 --export game.replay --width 1280 --height 720 --fps 60 |
+ *       ffmpeg -f rawvideo -pix_fmt rgba -s 1280x720 -r 60 -i - game.mp4
+ *
+ * Time is virtual: frame n shows the game n / fps seconds in, one move
+ * being played every moveIntervalMsec, so the output is the same however
+ * fast it renders. Tiles are only generated by the G moves of the replay.
+ */
+int exportReplay(const exportOptions &options) {
+    auto recorded = loadReplay(options.replay);
+    if (!recorded) {
+        std::cerr << "cannot read replay " << options.replay << "\n";
+        return 1;
+    }
+    auto out = options.output == "-" ? stdout
+                                     : std::fopen(options.output.c_str(), "wb");
+    if (!out) {
+        std::cerr << "cannot write " << options.output << "\n";
+        return 1;
+    }
+    std::setvbuf(out, nullptr, _IOFBF, 1 << 20);
+
+    sf::Vector2u size(options.width, options.height);
+    sf::RenderTexture frame;
+    if (!frame.create(size.x, size.y)) {
+        std::cerr << "cannot create a " << size.x << "x" << size.y
+                  << " render texture\n";
+        return 1;
+    }
+
+    tileAtlas atlas(config, latoBold, montserratRegular,
+                    assets.get("Lato-Bold.ttf"),
+                    assets.get("Montserrat-Regular.ttf"));
+    textLine scoreText(glyphs, latoBold, 40);
+    frameReadback readback(frame, out);
+
+    gameState game(recorded->size, recorded->seed);
+    game.initialize();
+    sceneLayout layout(size, game.matrix.size());
+
+    // hold the last frame until its scan and a little more are over
+    auto endMsec = std::int64_t(recorded->moves.size()) *
+                       options.moveIntervalMsec +
+                   1000;
+    std::size_t played = 0;
+    std::int64_t lastKeyMsec = -1, lastGeneratedMsec = 0;
+    auto paddedScanTimeMsec = (1 + scanWidthMultiplier) * scanTimeMsec;
+
+    auto start = std::chrono::steady_clock::now();
+    std::uint64_t frames = 0;
+    for (;; frames++) {
+        auto currentMsec = std::int64_t(frames) * 1000 / options.fps;
+        if (currentMsec > endMsec)
+            break;
+        while (played < recorded->moves.size() &&
+               std::int64_t(played + 1) * options.moveIntervalMsec <=
+                   currentMsec) {
+            auto move = recorded->moves[played];
+            auto moveMsec = std::int64_t(played + 1) * options.moveIntervalMsec;
+            auto changed = game.handleMove(move);
+            if (changed.changedByUserInteraction) {
+                lastKeyMsec = moveMsec;
+                lastMovement = move;
+            }
+            if (changed.generated)
+                lastGeneratedMsec = moveMsec;
+            played++;
+        }
+
+        frame.clear(sf::Color(0xd6d5d2ff));
+        if (game.lost) {
+            frame.draw(atlas.overlay(getGameStatusString(game), layout));
+        } else {
+            auto diff = currentMsec - lastGeneratedMsec;
+            if (cooldownMsec > diff)
+                drawCooldown(frame, layout,
+                             float(cooldownMsec - diff) / cooldownMsec);
+            drawBoard(frame, atlas, game, layout);
+            auto lastKeyElapsedMsec = currentMsec - lastKeyMsec;
+            if (lastKeyMsec >= 0 && lastKeyElapsedMsec < paddedScanTimeMsec)
+                drawScan(frame, layout, lastMovement, lastKeyElapsedMsec,
+                         scanTimeMsec, scanWidthMultiplier);
+        }
+        drawScore(frame, scoreText, game.score, layout);
+
+        if (!readback.push())
+            break;
+    }
+    bool written = readback.finish();
+    if (out != stdout)
+        written = std::fclose(out) == 0 && written;
+
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cerr << "Exported " << frames << " frames of " << size.x << "x"
+              << size.y << " in " << elapsed.count() << " s ("
+              << frames / elapsed.count() << " frames/s)\n";
+    if (!written) {
+        std::cerr << "cannot write " << options.output << "\n";
+        return 1;
     }
+    return 0;
 }
 
-int main() {
-    initializeGlobals();
+int main(int argc, char **argv) {
+    bool watchColors = false;
+    std::optional<exportOptions> exporting;
+    for (int i = 1; i < argc; i++) {
+        std::string_view flag = argv[i];
+        if (flag == "--watch-colors") {
+            watchColors = true;
+            continue;
+        }
+        if (i + 1 == argc) {
+            std::cerr << "unknown option " << flag << "\n";
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (flag == "--refresh-rate") {
+            if (!parseNumber(value, refreshRate) || !refreshRate) {
+                std::cerr << "invalid refresh rate " << value << "\n";
+                return 1;
+            }
+            continue;
+        }
+        if (flag == "--export") {
+            exporting = exporting.value_or(exportOptions());
+            exporting->replay = value;
+            continue;
+        }
+        // the remaining options only tune an export
+        if (!exporting)
+            exporting = exportOptions();
+        bool valid = true;
+        if (flag == "--output")
+            exporting->output = value;
+        else if (flag == "--width")
+            valid = parseNumber(value, exporting->width);
+        else if (flag == "--height")
+            valid = parseNumber(value, exporting->height);
+        else if (flag == "--fps")
+            valid = parseNumber(value, exporting->fps);
+        else if (flag == "--move-interval")
+            valid = parseNumber(value, exporting->moveIntervalMsec);
+        else {
+            std::cerr << "unknown option " << flag << "\n";
+            return 1;
+        }
+        if (!valid) {
+            std::cerr << "invalid export options\n";
+            return 1;
+        }
+    }
+    if (exporting && (exporting->replay.empty() || !exporting->width ||
+                      !exporting->height || !exporting->fps ||
+                      exporting->moveIntervalMsec <= 0)) {
+        std::cerr << "invalid export options\n";
+        return 1;
+    }
+
+    initializeGlobals(!exporting);
+    if (watchColors) {
+        colorWatcher = std::make_unique<fileWatcher>(
+            ".", std::vector<std::string>{"color.txt", "color2.txt"});
+        if (!colorWatcher->valid()) {
+            std::cerr << "cannot watch the colour tables for changes: "
+                      << std::strerror(errno) << "\n";
+            colorWatcher.reset();
+        }
+        reloadColors();
+    }
+    if (exporting)
+        return exportReplay(*exporting);
     entry();
-}
\ No newline at end of file
+}
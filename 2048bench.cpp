@@ -0,0 +1,217 @@
+#include "lib2048core.hpp"
+#include "lib2048protocol.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * Load generator for 2048d.
+ *
+ *   2048bench [--socket path] [--sessions 10000] [--connections 8]
+ *             [--batch 64] [--size 4] [--seconds 5]
+ *
+ * Every connection owns its share of the sessions and keeps one request per
+ * session in flight: each round pipelines a request for all of them and
+ * then reads the answers. With --batch 1 plain Move requests are sent,
+ * otherwise MoveBatch requests of that many moves.
+ */
+
+struct options {
+    std::string socket = DEFAULT_SOCKET_PATH;
+    unsigned int sessions = 10000, connections = 8, batch = 64, size = 4;
+    double seconds = 5;
+};
+
+int connectTo(const std::string &path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    auto fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr *>(&address),
+                           sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool sendAll(int fd, const std::vector<char> &buffer) {
+    std::size_t written = 0;
+    while (written < buffer.size()) {
+        auto length = send(fd, buffer.data() + written, buffer.size() - written,
+                           MSG_NOSIGNAL);
+        if (length <= 0)
+            return false;
+        written += length;
+    }
+    return true;
+}
+
+/**
+ * Read until `count` responses are complete, handing each one over.
+ */
+template <typename Handler>
+bool receive(int fd, std::vector<char> &buffer, std::size_t count,
+             Handler &&handler) {
+    char chunk[65536];
+    while (count) {
+        auto length = read(fd, chunk, sizeof(chunk));
+        if (length <= 0)
+            return false;
+        buffer.insert(buffer.end(), chunk, chunk + length);
+        forEachFrame(buffer, [&count, &handler](frameReader in) {
+            count--;
+            handler(in);
+        });
+    }
+    return true;
+}
+
+void client(const options &config, unsigned int sessionCount,
+            std::uint64_t seed, const std::atomic<bool> &stop,
+            std::atomic<std::uint64_t> &moves,
+            std::atomic<std::uint64_t> &effective, std::atomic<bool> &failed) {
+    auto fd = connectTo(config.socket);
+    if (fd < 0) {
+        failed = true;
+        return;
+    }
+
+    std::vector<char> out, in;
+    std::vector<std::uint32_t> sessions;
+    for (unsigned int i = 0; i < sessionCount; i++)
+        frameWriter(out, std::uint8_t(requestType::NewGame))
+            .put(std::uint8_t(config.size))
+            .put(seed + i);
+    if (!sendAll(fd, out) ||
+        !receive(fd, in, sessionCount, [&sessions](frameReader response) {
+            std::uint8_t status;
+            std::uint32_t id;
+            if (response.get(status) && response.get(id))
+                sessions.push_back(id);
+        }) ||
+        sessions.size() != sessionCount) {
+        failed = true;
+        close(fd);
+        return;
+    }
+
+    std::mt19937_64 random(seed);
+    std::vector<bool> lost(sessionCount);
+    auto nextMove = [&random]() {
+        return std::uint8_t(std::uint8_t(gameMovement::Up) + random() % 4);
+    };
+    while (!stop) {
+        out.clear();
+        for (unsigned int i = 0; i < sessionCount; i++) {
+            // lost games are restarted by their next request
+            if (config.batch == 1) {
+                frameWriter(out, std::uint8_t(requestType::Move))
+                    .put(sessions[i])
+                    .put(lost[i] ? std::uint8_t(gameMovement::META_Restart)
+                                 : nextMove());
+                continue;
+            }
+            frameWriter request(out, std::uint8_t(requestType::MoveBatch));
+            request.put(sessions[i]).put(std::uint16_t(config.batch));
+            for (unsigned int move = 0; move < config.batch; move++)
+                request.put(lost[i] && !move
+                                ? std::uint8_t(gameMovement::META_Restart)
+                                : nextMove());
+        }
+
+        std::size_t index = 0;
+        std::uint64_t changedMoves = 0;
+        if (!sendAll(fd, out) ||
+            !receive(fd, in, sessionCount,
+                     [&lost, &index, &changedMoves,
+                      &config](frameReader response) {
+                         std::uint8_t status = 0, flags = 0;
+                         std::uint16_t changed = 0;
+                         response.get(status);
+                         if (config.batch != 1)
+                             response.get(changed);
+                         response.get(flags);
+                         if (config.batch == 1)
+                             changed = flags & moveFlags::Changed;
+                         changedMoves += changed;
+                         lost[index++] =
+                             responseStatus(status) == responseStatus::Ok &&
+                             (flags & moveFlags::Lost);
+                     })) {
+            failed = true;
+            break;
+        }
+        moves += std::uint64_t(sessionCount) * config.batch;
+        effective += changedMoves;
+    }
+    close(fd);
+}
+
+int main(int argc, char **argv) {
+    options config;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i], value = argv[i + 1];
+        if (flag == "--socket")
+            config.socket = value;
+        else if (flag == "--sessions")
+            config.sessions = std::stoul(value);
+        else if (flag == "--connections")
+            config.connections = std::stoul(value);
+        else if (flag == "--batch")
+            config.batch = std::stoul(value);
+        else if (flag == "--size")
+            config.size = std::stoul(value);
+        else if (flag == "--seconds")
+            config.seconds = std::stod(value);
+        else {
+            std::cerr << "unknown option " << flag << "\n";
+            return 1;
+        }
+    }
+    if (!config.connections || config.sessions < config.connections ||
+        !config.batch || config.batch > 65535 ||
+        !supportedGameSize(config.size)) {
+        std::cerr << "invalid options\n";
+        return 1;
+    }
+
+    std::atomic<bool> stop = false, failed = false;
+    // moves sent, and moves that changed a board
+    std::atomic<std::uint64_t> moves = 0, effective = 0;
+    std::vector<std::thread> clients;
+    for (unsigned int i = 0; i < config.connections; i++) {
+        auto share = config.sessions / config.connections +
+                     (i < config.sessions % config.connections);
+        clients.emplace_back(client, std::cref(config), share,
+                             std::uint64_t(i) << 32, std::cref(stop),
+                             std::ref(moves), std::ref(effective),
+                             std::ref(failed));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(config.seconds));
+    stop = true;
+    for (auto &thread : clients)
+        thread.join();
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    if (failed) {
+        std::cerr << "cannot talk to 2048d on " << config.socket << "\n";
+        return 1;
+    }
+    std::cout << config.sessions << " sessions over " << config.connections
+              << " connections, " << moves << " moves in " << elapsed.count()
+              << " s: " << std::uint64_t(moves / elapsed.count())
+              << " moves/s, " << std::uint64_t(effective / elapsed.count())
+              << " board-changing moves/s\n";
+}
@@ -0,0 +1,347 @@
+#include "lib2048core.hpp"
+#include "lib2048protocol.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Headless game server, hosting many games over a Unix domain socket.
+ *
+ *   2048d [socket path]
+ *
+ * See lib2048protocol.hpp for the wire format.
+ */
+
+volatile std::sig_atomic_t stopping = 0;
+
+struct session {
+    gameState game;
+    int owner;
+    bool active;
+};
+
+/**
+ * Session storage. Slots are never freed: an ended game goes to a free
+ * list and its matrix is reused by the next game of the same size.
+ */
+class sessionPool {
+  public:
+    std::uint32_t acquire(gameSize size, std::uint64_t seed, int owner) {
+        std::uint32_t index;
+        if (this->unused.empty()) {
+            index = this->slots.size();
+            this->slots.push_back({gameState(size, seed), owner, true});
+            this->slots.back().game.initialize();
+        } else {
+            index = this->unused.back();
+            this->unused.pop_back();
+            auto &slot = this->slots[index];
+            slot.game.reset(size, seed);
+            slot.owner = owner;
+            slot.active = true;
+        }
+        return index + 1;
+    }
+
+    session *find(std::uint32_t id, int owner) {
+        if (id == 0 || id > this->slots.size())
+            return nullptr;
+        auto &slot = this->slots[id - 1];
+        return slot.active && slot.owner == owner ? &slot : nullptr;
+    }
+
+    void release(std::uint32_t id) {
+        this->slots[id - 1].active = false;
+        this->unused.push_back(id - 1);
+    }
+
+  private:
+    // a deque keeps sessions in place as the pool grows
+    std::deque<session> slots;
+    std::vector<std::uint32_t> unused;
+};
+
+struct connection {
+    int fd;
+    std::vector<char> in, out;
+    std::vector<std::uint32_t> sessions;
+    bool writing = false;
+};
+
+class server {
+  public:
+    explicit server(int listener) : listener(listener) {
+        this->epoll = epoll_create1(EPOLL_CLOEXEC);
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = listener;
+        epoll_ctl(this->epoll, EPOLL_CTL_ADD, listener, &event);
+    }
+
+    void run() {
+        std::vector<epoll_event> events(256);
+        while (!stopping) {
+            auto count = epoll_wait(this->epoll, events.data(), events.size(),
+                                    1000);
+            for (int i = 0; i < count; i++) {
+                auto fd = events[i].data.fd;
+                if (fd == this->listener) {
+                    this->accept();
+                    continue;
+                }
+                auto it = this->connections.find(fd);
+                if (it == this->connections.end())
+                    continue;
+                auto &client = *it->second;
+                bool alive = !(events[i].events & (EPOLLERR | EPOLLHUP)) ||
+                             (events[i].events & EPOLLIN);
+                if (alive && (events[i].events & EPOLLIN))
+                    alive = this->receive(client);
+                if (alive)
+                    alive = this->flush(client);
+                if (!alive)
+                    this->disconnect(client);
+            }
+        }
+    }
+
+  private:
+    int listener, epoll;
+    sessionPool sessions;
+    std::unordered_map<int, std::unique_ptr<connection>> connections;
+
+    void accept() {
+        int fd;
+        while ((fd = accept4(this->listener, nullptr, nullptr,
+                             SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+            auto client = std::make_unique<connection>();
+            client->fd = fd;
+            epoll_event event{};
+            event.events = EPOLLIN | EPOLLRDHUP;
+            event.data.fd = fd;
+            epoll_ctl(this->epoll, EPOLL_CTL_ADD, fd, &event);
+            this->connections[fd] = std::move(client);
+        }
+    }
+
+    void disconnect(connection &client) {
+        for (auto id : client.sessions)
+            if (this->sessions.find(id, client.fd))
+                this->sessions.release(id);
+        epoll_ctl(this->epoll, EPOLL_CTL_DEL, client.fd, nullptr);
+        close(client.fd);
+        this->connections.erase(client.fd);
+    }
+
+    /**
+     * Drain the socket, then answer every complete request at once so that
+     * a pipelined burst costs a single write.
+     */
+    bool receive(connection &client) {
+        char buffer[65536];
+        bool open = true;
+        while (true) {
+            auto length = read(client.fd, buffer, sizeof(buffer));
+            if (length > 0) {
+                client.in.insert(client.in.end(), buffer, buffer + length);
+                continue;
+            }
+            if (length == 0)
+                open = false;
+            else if (errno != EAGAIN && errno != EWOULDBLOCK)
+                return false;
+            break;
+        }
+        bool valid = forEachFrame(client.in, [this, &client](frameReader in) {
+            this->handle(client, in);
+        });
+        return valid && (open || !client.out.empty());
+    }
+
+    bool flush(connection &client) {
+        std::size_t written = 0;
+        while (written < client.out.size()) {
+            auto length = send(client.fd, client.out.data() + written,
+                               client.out.size() - written, MSG_NOSIGNAL);
+            if (length < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    break;
+                return false;
+            }
+            written += length;
+        }
+        client.out.erase(client.out.begin(), client.out.begin() + written);
+
+        // only wait for writability while there is something left to send
+        bool writing = !client.out.empty();
+        if (writing != client.writing) {
+            epoll_event event{};
+            event.events = EPOLLIN | EPOLLRDHUP | (writing ? EPOLLOUT : 0);
+            event.data.fd = client.fd;
+            epoll_ctl(this->epoll, EPOLL_CTL_MOD, client.fd, &event);
+            client.writing = writing;
+        }
+        return true;
+    }
+
+    static std::uint8_t flagsOf(const diff &result, const gameState &game) {
+        return (result.changedByUserInteraction ? moveFlags::Changed : 0) |
+               (result.generated ? moveFlags::Generated : 0) |
+               (game.lost ? moveFlags::Lost : 0);
+    }
+
+    static bool validMove(std::uint8_t move) {
+        return move >= std::uint8_t(gameMovement::Up) &&
+               move <= std::uint8_t(gameMovement::META_RandomlyGenerate);
+    }
+
+    void handle(connection &client, frameReader in) {
+        auto &out = client.out;
+        auto reply = [&out](responseStatus status) {
+            frameWriter(out, std::uint8_t(status));
+        };
+
+        std::uint8_t type;
+        if (!in.get(type))
+            return reply(responseStatus::BadRequest);
+
+        if (requestType(type) == requestType::NewGame) {
+            std::uint8_t size;
+            std::uint64_t seed;
+            if (!in.get(size) || !in.get(seed) || !supportedGameSize(size))
+                return reply(responseStatus::BadRequest);
+            auto id = this->sessions.acquire(size, seed, client.fd);
+            client.sessions.push_back(id);
+            frameWriter(out, std::uint8_t(responseStatus::Ok)).put(id);
+            return;
+        }
+
+        std::uint32_t id;
+        if (!in.get(id))
+            return reply(responseStatus::BadRequest);
+        auto current = this->sessions.find(id, client.fd);
+        if (!current)
+            return reply(responseStatus::UnknownSession);
+        auto &game = current->game;
+
+        switch (requestType(type)) {
+        case requestType::Move: {
+            std::uint8_t move;
+            if (!in.get(move) || !validMove(move))
+                return reply(responseStatus::BadRequest);
+            auto result = game.handleMove(gameMovement(move));
+            frameWriter(out, std::uint8_t(responseStatus::Ok))
+                .put(flagsOf(result, game))
+                .put(game.score);
+            return;
+        }
+        case requestType::MoveBatch: {
+            std::uint16_t count;
+            if (!in.get(count) || in.remaining() != count)
+                return reply(responseStatus::BadRequest);
+            auto moves = in.data();
+            if (!std::all_of(moves, moves + count, [](char move) {
+                    return validMove(std::uint8_t(move));
+                }))
+                return reply(responseStatus::BadRequest);
+            std::uint16_t changed = 0;
+            diff result{false, false};
+            for (std::uint16_t i = 0; i < count; i++) {
+                result = game.handleMove(gameMovement(moves[i]));
+                changed += result.changedByUserInteraction;
+            }
+            frameWriter(out, std::uint8_t(responseStatus::Ok))
+                .put(changed)
+                .put(flagsOf(result, game))
+                .put(game.score);
+            return;
+        }
+        case requestType::GetBoard: {
+            frameWriter board(out, std::uint8_t(responseStatus::Ok));
+            board.put(std::uint8_t(game.matrix.size()))
+                .put(std::uint8_t(game.lost ? moveFlags::Lost : 0))
+                .put(game.score);
+            for (const auto &row : game.matrix)
+                for (auto value : row)
+                    board.put(std::uint8_t(exponentOf(value)));
+            return;
+        }
+        case requestType::EndGame: {
+            this->sessions.release(id);
+            std::erase(client.sessions, id);
+            return reply(responseStatus::Ok);
+        }
+        default:
+            return reply(responseStatus::BadRequest);
+        }
+    }
+};
+
+/**
+ * Remove a socket left behind by a daemon that is gone. Anything else at the
+ * path, a running daemon included, is left alone.
+ */
+bool removeStaleSocket(const std::string &path, const sockaddr_un &address) {
+    struct stat info;
+    if (lstat(path.c_str(), &info) != 0)
+        return errno == ENOENT;
+    if (!S_ISSOCK(info.st_mode))
+        return false;
+    auto probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (probe < 0)
+        return false;
+    bool stale = connect(probe, reinterpret_cast<const sockaddr *>(&address),
+                         sizeof(address)) != 0 &&
+                 errno == ECONNREFUSED;
+    close(probe);
+    return stale && unlink(path.c_str()) == 0;
+}
+
+int main(int argc, char **argv) {
+    std::string path = argc > 1 ? argv[1] : DEFAULT_SOCKET_PATH;
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "socket path too long: " << path << "\n";
+        return 1;
+    }
+    std::strcpy(address.sun_path, path.c_str());
+
+    if (!removeStaleSocket(path, address)) {
+        std::cerr << "cannot listen on " << path
+                  << ": in use by another 2048d or not a socket\n";
+        return 1;
+    }
+    auto listener =
+        socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listener < 0 ||
+        bind(listener, reinterpret_cast<sockaddr *>(&address),
+             sizeof(address)) != 0 ||
+        listen(listener, SOMAXCONN) != 0) {
+        std::cerr << "cannot listen on " << path << ": " << std::strerror(errno)
+                  << "\n";
+        return 1;
+    }
+
+    std::signal(SIGINT, [](int) { stopping = 1; });
+    std::signal(SIGTERM, [](int) { stopping = 1; });
+    std::cout << "2048d listening on " << path << std::endl;
+
+    server(listener).run();
+
+    close(listener);
+    unlink(path.c_str());
+}
@@ -0,0 +1,107 @@
+#include "lib2048assets.hpp"
+#include <SFML/Audio.hpp>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+/**
+ * Build step packing the game assets into a single bundle.
+ *
+ *   2048pack <output> <asset>...
+ *   2048pack --embed <output.cpp> <asset>...
+ *
+ * WAV files are re-encoded to FLAC, which sf::SoundBuffer and sf::Music
+ * decode straight from memory. Assets are stored under their file name.
+ */
+
+std::vector<char> readFile(const std::filesystem::path &path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file),
+                             std::istreambuf_iterator<char>());
+}
+
+std::vector<char> compressAudio(const std::filesystem::path &path,
+                                const std::filesystem::path &scratch) {
+    sf::InputSoundFile input;
+    if (!input.openFromFile(path.string()))
+        return {};
+    {
+        sf::OutputSoundFile output;
+        if (!output.openFromFile(scratch.string(), input.getSampleRate(),
+                                 input.getChannelCount()))
+            return {};
+        std::vector<sf::Int16> samples(65536);
+        while (auto count = input.read(samples.data(), samples.size()))
+            output.write(samples.data(), count);
+    }
+    auto compressed = readFile(scratch);
+    std::filesystem::remove(scratch);
+    return compressed;
+}
+
+template <typename T> void append(std::vector<char> &out, T value) {
+    auto bytes = reinterpret_cast<const char *>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+int main(int argc, char **argv) {
+    bool embed = argc > 1 && std::string(argv[1]) == "--embed";
+    int first = embed ? 3 : 2;
+    if (argc < first) {
+        std::cerr << "usage: " << argv[0] << " [--embed] <output> <asset>...\n";
+        return 1;
+    }
+    std::filesystem::path output(argv[first - 1]);
+
+    std::vector<std::pair<std::string, std::vector<char>>> assets;
+    for (int i = first; i < argc; i++) {
+        std::filesystem::path path(argv[i]);
+        auto contents =
+            path.extension() == ".wav"
+                ? compressAudio(path, output.parent_path() /
+                                          (path.stem().string() + ".flac"))
+                : readFile(path);
+        if (contents.empty()) {
+            std::cerr << "cannot pack " << path << "\n";
+            return 1;
+        }
+        assets.emplace_back(path.filename().string(), std::move(contents));
+    }
+
+    std::vector<char> bundle(BUNDLE_MAGIC.begin(), BUNDLE_MAGIC.end());
+    append<std::uint32_t>(bundle, assets.size());
+    std::uint64_t offset = bundle.size();
+    for (const auto &[name, contents] : assets)
+        offset += sizeof(std::uint16_t) + name.size() + 2 * sizeof(offset);
+    for (const auto &[name, contents] : assets) {
+        append<std::uint16_t>(bundle, name.size());
+        bundle.insert(bundle.end(), name.begin(), name.end());
+        append<std::uint64_t>(bundle, offset);
+        append<std::uint64_t>(bundle, contents.size());
+        offset += contents.size();
+    }
+    for (const auto &[name, contents] : assets)
+        bundle.insert(bundle.end(), contents.begin(), contents.end());
+
+    std::ofstream out(output, std::ios::binary);
+    if (!embed) {
+        out.write(bundle.data(), bundle.size());
+        return out ? 0 : 1;
+    }
+
+    out << "#include <cstddef>\n\n"
+        << "alignas(8) extern const unsigned char embeddedAssets[] = {";
+    for (std::size_t i = 0; i < bundle.size(); i++) {
+        char byte[8];
+        std::snprintf(byte, sizeof(byte), "%s%u,", i % 24 ? "" : "\n",
+                      static_cast<unsigned char>(bundle[i]));
+        out << byte;
+    }
+    out << "};\nextern const std::size_t embeddedAssetsSize = " << bundle.size()
+        << ";\n";
+    return out ? 0 : 1;
+}
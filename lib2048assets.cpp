@@ -0,0 +1,96 @@
+#include "lib2048assets.hpp"
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+assetBundle::~assetBundle() {
+    if (this->mapping)
+        munmap(this->mapping, this->mappingSize);
+}
+
+bool assetBundle::open(const std::string &path) {
+    auto fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+    auto mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping stays valid after the descriptor is closed
+    close(fd);
+    if (mapping == MAP_FAILED)
+        return false;
+    // every asset is needed at startup anyway
+    madvise(mapping, info.st_size, MADV_WILLNEED);
+
+    if (!this->parse(static_cast<const char *>(mapping), info.st_size)) {
+        munmap(mapping, info.st_size);
+        return false;
+    }
+    this->mapping = mapping;
+    this->mappingSize = info.st_size;
+    return true;
+}
+
+bool assetBundle::attach(const void *data, std::size_t size) {
+    return this->parse(static_cast<const char *>(data), size);
+}
+
+bool assetBundle::parse(const char *data, std::size_t size) {
+    auto cursor = data, end = data + size;
+    auto read = [&cursor, end](void *out, std::size_t length) {
+        if (std::size_t(end - cursor) < length)
+            return false;
+        std::memcpy(out, cursor, length);
+        cursor += length;
+        return true;
+    };
+
+    char magic[BUNDLE_MAGIC.size()];
+    std::uint32_t count;
+    if (!read(magic, sizeof(magic)) ||
+        std::string_view(magic, sizeof(magic)) != BUNDLE_MAGIC ||
+        !read(&count, sizeof(count)))
+        return false;
+
+    decltype(this->index) index;
+    for (std::uint32_t i = 0; i < count; i++) {
+        std::uint16_t nameLength;
+        std::uint64_t offset, length;
+        if (!read(&nameLength, sizeof(nameLength)) ||
+            std::size_t(end - cursor) < nameLength)
+            return false;
+        std::string name(cursor, nameLength);
+        cursor += nameLength;
+        if (!read(&offset, sizeof(offset)) || !read(&length, sizeof(length)) ||
+            offset > size || length > size - offset)
+            return false;
+        index[name] = assetData(data + offset, length);
+    }
+    this->index = std::move(index);
+    return true;
+}
+
+assetData assetBundle::get(std::string_view name) {
+    if (auto it = this->index.find(name); it != this->index.end())
+        return it->second;
+    if (auto it = this->looseFiles.find(name); it != this->looseFiles.end())
+        return it->second;
+
+    std::ifstream file("./" + std::string(name), std::ios::binary);
+    auto &contents = this->looseFiles[std::string(name)];
+    contents.assign(std::istreambuf_iterator<char>(file),
+                    std::istreambuf_iterator<char>());
+    return contents;
+}
+
+std::string_view assetBundle::text(std::string_view name) {
+    auto data = this->get(name);
+    return std::string_view(data.data(), data.size());
+}
@@ -0,0 +1,54 @@
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifndef _2048ASSETS
+#define _2048ASSETS
+
+/**
+ * Bundle layout, all integers in host byte order:
+ *
+ *   char          magic[8]
+ *   std::uint32_t count
+ *   count x { std::uint16_t nameLength; char name[nameLength];
+ *             std::uint64_t offset; std::uint64_t size; }
+ *   data, offsets being relative to the start of the bundle
+ */
+constexpr std::string_view BUNDLE_MAGIC{"2048PAK\1", 8};
+
+typedef std::span<const char> assetData;
+
+/**
+ * Read-only view over a packed asset bundle, either memory-mapped from disk
+ * or embedded into the executable.
+ *
+ * When no bundle can be found, loose files from the working directory are
+ * read instead so that the game still runs straight from the source tree.
+ */
+class assetBundle {
+  public:
+    assetBundle() = default;
+    assetBundle(const assetBundle &) = delete;
+    assetBundle &operator=(const assetBundle &) = delete;
+    ~assetBundle();
+
+    bool open(const std::string &path);
+    bool attach(const void *data, std::size_t size);
+
+    assetData get(std::string_view name);
+    std::string_view text(std::string_view name);
+
+  private:
+    void *mapping = nullptr;
+    std::size_t mappingSize = 0;
+    std::map<std::string, assetData, std::less<>> index;
+    std::map<std::string, std::vector<char>, std::less<>> looseFiles;
+
+    bool parse(const char *data, std::size_t size);
+};
+
+#endif
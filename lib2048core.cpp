@@ -1,27 +1,58 @@
+#include "defaultColors.hpp"
 #include "lib2048core.hpp"
-#include "lib2048utils.hpp"
 #include <algorithm>
-#include <charconv>
-#include <fstream>
 #include <numeric>
 #include <queue>
 #include <random>
 #include <set>
-#include <sstream>
 #include <string>
 #include <tuple>
 
 gameState::gameState(gameSize size)
-    : size(size),
-      random(std::chrono::system_clock::now().time_since_epoch().count()),
-      matrix(size) {
+    : gameState(size,
+                std::chrono::system_clock::now().time_since_epoch().count()) {}
+
+gameState::gameState(gameSize size, std::uint64_t seed)
+    : matrix(size), size(size), seed(seed), random(seed) {
     for (auto &row : this->matrix)
         row.assign(this->size, 0);
 }
 
+gameState::gameState(const gameSnapshot &snapshot)
+    : matrix(snapshot.size), score(snapshot.score), lost(snapshot.lost),
+      size(snapshot.size), seed(snapshot.seed), draws(snapshot.draws),
+      random(snapshot.seed) {
+    this->random.discard(snapshot.draws);
+    auto exponent = snapshot.exponents.begin();
+    for (auto &row : this->matrix) {
+        row.resize(this->size);
+        for (auto &cell : row) {
+            cell = *exponent ? gameValue(1) << *exponent : 0;
+            ++exponent;
+        }
+    }
+}
+
+gameSnapshot gameState::snapshot() const {
+    gameSnapshot snapshot{this->size, this->score, this->lost, this->seed,
+                          this->draws};
+    snapshot.exponents.reserve(this->size * this->size);
+    for (const auto &row : this->matrix)
+        for (auto cell : row)
+            snapshot.exponents.push_back(exponentOf(cell));
+    return snapshot;
+}
+
+std::uint64_t gameState::draw() {
+    ++this->draws;
+    return this->random();
+}
+
 void gameState::initialize() {
     this->lost = false;
     this->score = 0;
+    for (auto &row : this->matrix)
+        std::fill(row.begin(), row.end(), 0);
 
     auto cellInitNbr = this->size >> 1;
     std::size_t count = 0;
@@ -30,6 +61,17 @@ void gameState::initialize() {
     }
 }
 
+void gameState::reset(gameSize size, std::uint64_t seed) {
+    this->size = size;
+    this->seed = seed;
+    this->draws = 0;
+    this->random.seed(seed);
+    this->matrix.resize(size);
+    for (auto &row : this->matrix)
+        row.assign(size, 0);
+    this->initialize();
+}
+
 bool gameState::newCell() {
     std::vector<decltype(this->matrix[0].begin())> positions;
     std::for_each(this->matrix.begin(), this->matrix.end(),
@@ -41,12 +83,12 @@ bool gameState::newCell() {
                   });
     if (positions.empty())
         return false;
-    auto ranIdx = this->random() % positions.size();
+    auto ranIdx = this->draw() % positions.size();
     *positions[ranIdx] = this->generate();
     return true;
 }
 
-constexpr std::size_t gameState::count() {
+std::size_t gameState::count() {
     return std::accumulate(
         this->matrix.begin(), this->matrix.end(), 0,
         [](std::size_t base, const auto &_) {
@@ -56,8 +98,8 @@ constexpr std::size_t gameState::count() {
         });
 }
 
-constexpr gameValue gameState::generate() {
-    return (this->random() % 10) > 8 ? 4 : 2;
+gameValue gameState::generate() {
+    return (this->draw() % 10) > 8 ? 4 : 2;
 }
 
 template <typename Iterator>
@@ -89,7 +131,7 @@ constexpr std::pair<bool, gameValue> __merge(const Iterator &begin,
 
 diff gameState::handleMove(gameMovement move) {
     bool changed = false;
-    if (this->lost)
+    if (this->lost && move != gameMovement::META_Restart)
         return {false, false};
     switch (move) {
     case gameMovement::Up:
@@ -148,7 +190,7 @@ diff gameState::handleMove(gameMovement move) {
     return {changed, generated};
 }
 
-constexpr bool gameState::checkLosingState() {
+bool gameState::checkLosingState() {
     auto size = this->size;
     for (gameSize row = 0; row < size; row++)
         for (gameSize column = 0; column < size; column++) {
@@ -172,48 +214,29 @@ constexpr bool gameState::checkLosingState() {
     return true;
 }
 
-std::map<gameValue, sf::Color> loadColorMapping(std::string path);
-void gameConfig::setup() {
-    this->cellColorMapping = loadColorMapping("./color.txt");
-    this->textColorMapping = loadColorMapping("./color2.txt");
+// default colour tables, parsed while compiling
+constexpr colorTable DEFAULT_CELL_COLOR_TABLE =
+    parseColorTable(DEFAULT_CELL_COLORS);
+constexpr colorTable DEFAULT_TEXT_COLOR_TABLE =
+    parseColorTable(DEFAULT_TEXT_COLORS);
+
+gameConfig::gameConfig()
+    : cellColors(DEFAULT_CELL_COLOR_TABLE),
+      textColors(DEFAULT_TEXT_COLOR_TABLE) {}
+
+void gameConfig::setup(std::string_view cellColors,
+                       std::string_view textColors) {
+    // parse both first so that a malformed table leaves the config untouched
+    auto cells = parseColorTable(cellColors);
+    auto texts = parseColorTable(textColors);
+    this->cellColors = cells;
+    this->textColors = texts;
 }
 
-std::map<gameValue, sf::Color> loadColorMapping(std::string path) {
-    std::stringstream buf;
-    buf << (std::ifstream(path)).rdbuf();
-    // Keep the string alive
-    auto const &lit_copy = buf.str();
-    auto lines = split(lit_copy, "\n");
-    // TODO: Convert to ranges::transform
-    std::transform(lines.begin(), lines.end(), lines.begin(), trim);
-    std::erase_if(lines, [](const auto &s) { return !s.length(); });
-    std::map<gameValue, sf::Color> ____;
-    std::for_each(
-        lines.begin(), lines.end(), [&____, &lit_copy](const auto &s) {
-            auto _ = split(s, "=");
-            std::transform(_.begin(), _.end(), _.begin(), trim);
-            long long cap;
-            auto conv_res =
-                std::from_chars(_[0].data(), _[0].data() + _[0].size(), cap);
-            if (conv_res.ec != std::errc() || _.size() != 2) {
-                throw std::exception();
-            }
-            auto colors = split(_[1], ",");
-            std::vector<long> __(colors.size());
-            std::transform(colors.begin(), colors.end(), __.begin(),
-                           [](const auto &s) -> long {
-                               auto trimmed = trim(s);
-                               long num;
-                               auto result = std::from_chars(
-                                   trimmed.data(),
-                                   trimmed.data() + trimmed.size(), num, 16);
-                               if (result.ec == std::errc()) {
-                                   return num;
-                               }
-                               return 0;
-                           });
-            ____[cap] = sf::Color(__[0], __[1], __[2],
-                                  colors.size() >= 4 ? __[3] : 196);
-        });
-    return ____;
-}
\ No newline at end of file
+std::bitset<64> gameConfig::difference(const gameConfig &other) const {
+    std::bitset<64> changed;
+    for (std::size_t i = 0; i < changed.size(); i++)
+        changed[i] = this->cellColors[i] != other.cellColors[i] ||
+                     this->textColors[i] != other.textColors[i];
+    return changed;
+}
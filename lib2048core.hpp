@@ -1,9 +1,13 @@
-#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <bitset>
 #include <chrono>
 #include <cstdint>
-#include <map>
 #include <random>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #ifndef _2048CORE
@@ -12,6 +16,18 @@
 typedef std::int64_t gameValue;
 typedef std::size_t gameSize;
 
+// Board sizes the game is played on, each move spawning size / 4 tiles
+constexpr std::array<gameSize, 3> GAME_SIZES{4, 8, 16};
+constexpr bool supportedGameSize(gameSize size) {
+    return std::find(GAME_SIZES.begin(), GAME_SIZES.end(), size) !=
+           GAME_SIZES.end();
+}
+
+// Index of a tile value among the powers of two, 0 for an empty cell
+constexpr std::size_t exponentOf(gameValue value) {
+    return value > 0 ? std::countr_zero(static_cast<std::uint64_t>(value)) : 0;
+}
+
 enum class gameMovement {
     Up = 1,
     Right,
@@ -21,11 +37,105 @@ enum class gameMovement {
     META_RandomlyGenerate
 };
 
+struct paletteEntry {
+    bool present = false;
+    std::uint8_t r = 0, g = 0, b = 0, a = 0;
+    constexpr bool operator==(const paletteEntry &) const = default;
+};
+
+// Colours of every possible tile, indexed by exponentOf(value)
+typedef std::array<paletteEntry, 64> colorTable;
+
+/**
+ * Parse lines of `value = rr,gg,bb[,aa]`, components being hexadecimal and
+ * alpha defaulting to 196. Throws std::invalid_argument on malformed input,
+ * which fails the build when evaluated at compile time.
+ */
+constexpr colorTable parseColorTable(std::string_view contents) {
+    auto strip = [](std::string_view s) {
+        auto blank = [](char c) { return c == ' ' || c == '\t' || c == '\r'; };
+        while (!s.empty() && blank(s.front()))
+            s.remove_prefix(1);
+        while (!s.empty() && blank(s.back()))
+            s.remove_suffix(1);
+        return s;
+    };
+    auto number = [](std::string_view s, unsigned int base) {
+        if (s.empty() || s.size() > 18)
+            throw std::invalid_argument("malformed number in color table");
+        std::uint64_t out = 0;
+        for (char c : s) {
+            unsigned int digit = (c >= '0' && c <= '9')   ? c - '0'
+                                 : (c >= 'a' && c <= 'f') ? c - 'a' + 10
+                                 : (c >= 'A' && c <= 'F') ? c - 'A' + 10
+                                                          : base;
+            if (digit >= base)
+                throw std::invalid_argument("malformed number in color table");
+            out = out * base + digit;
+        }
+        return out;
+    };
+
+    colorTable table{};
+    while (!contents.empty()) {
+        auto end = contents.find('\n');
+        auto line = strip(contents.substr(0, end));
+        contents.remove_prefix(end == std::string_view::npos ? contents.size()
+                                                             : end + 1);
+        if (line.empty())
+            continue;
+
+        auto equals = line.find('=');
+        if (equals == std::string_view::npos)
+            throw std::invalid_argument("missing '=' in color table");
+        auto value = number(strip(line.substr(0, equals)), 10);
+        if (value == 1 || (value & (value - 1)))
+            throw std::invalid_argument("color table keys must be tiles");
+
+        std::array<std::uint64_t, 4> components{0, 0, 0, 196};
+        std::size_t count = 0;
+        for (auto rest = line.substr(equals + 1);; count++) {
+            auto comma = rest.find(',');
+            if (count == components.size())
+                throw std::invalid_argument("too many color components");
+            components[count] = number(strip(rest.substr(0, comma)), 16);
+            if (components[count] > 0xFF)
+                throw std::invalid_argument("color component out of range");
+            if (comma == std::string_view::npos)
+                break;
+            rest.remove_prefix(comma + 1);
+        }
+        if (count < 2)
+            throw std::invalid_argument("too few color components");
+
+        table[exponentOf(value)] = {
+            true, std::uint8_t(components[0]), std::uint8_t(components[1]),
+            std::uint8_t(components[2]), std::uint8_t(components[3])};
+    }
+    return table;
+}
+
 class gameConfig {
   public:
-    std::map<gameValue, sf::Color> cellColorMapping;
-    std::map<gameValue, sf::Color> textColorMapping;
-    void setup();
+    colorTable cellColors;
+    colorTable textColors;
+    // starts with the colour tables embedded at build time
+    gameConfig();
+    void setup(std::string_view cellColors, std::string_view textColors);
+    std::bitset<64> difference(const gameConfig &) const;
+};
+
+/**
+ * Everything needed to resume a game. The generator is kept as its seed and
+ * the number of values drawn from it since.
+ */
+struct gameSnapshot {
+    gameSize size;
+    gameValue score;
+    bool lost;
+    std::uint64_t seed, draws;
+    // exponentOf() of every cell, row by row
+    std::vector<std::uint8_t> exponents;
 };
 
 struct diff {
@@ -39,16 +149,23 @@ class gameState {
     gameValue score;
     bool lost;
     gameState(gameSize);
+    gameState(gameSize, std::uint64_t seed);
+    explicit gameState(const gameSnapshot &);
     void initialize();
+    // start over with another size and seed, reusing the matrix storage
+    void reset(gameSize, std::uint64_t seed);
     diff handleMove(gameMovement);
+    gameSnapshot snapshot() const;
 
   private:
-    constexpr bool checkLosingState();
+    bool checkLosingState();
     gameSize size;
+    std::uint64_t seed, draws = 0;
     std::mt19937_64 random;
-    constexpr gameValue generate();
+    std::uint64_t draw();
+    gameValue generate();
     bool newCell();
-    constexpr std::size_t count();
+    std::size_t count();
 };
 
 #endif
\ No newline at end of file
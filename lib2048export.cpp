@@ -0,0 +1,152 @@
+#include "lib2048export.hpp"
+#include <SFML/OpenGL.hpp>
+#include <GL/glext.h>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+
+std::optional<replay> loadReplay(const std::string &path) {
+    std::ifstream file(path);
+    if (!file)
+        return std::nullopt;
+
+    std::string contents, line;
+    while (std::getline(file, line))
+        contents += line.substr(0, line.find('#')) + "\n";
+
+    std::istringstream stream(contents);
+    replay game;
+    if (!(stream >> game.size >> game.seed) || !supportedGameSize(game.size))
+        return std::nullopt;
+
+    char move;
+    while (stream >> move) {
+        switch (std::toupper(move)) {
+        case 'U':
+            game.moves.push_back(gameMovement::Up);
+            break;
+        case 'R':
+            game.moves.push_back(gameMovement::Right);
+            break;
+        case 'D':
+            game.moves.push_back(gameMovement::Down);
+            break;
+        case 'L':
+            game.moves.push_back(gameMovement::Left);
+            break;
+        case 'N':
+            game.moves.push_back(gameMovement::META_Restart);
+            break;
+        case 'G':
+            game.moves.push_back(gameMovement::META_RandomlyGenerate);
+            break;
+        default:
+            return std::nullopt;
+        }
+    }
+    return game;
+}
+
+// buffer object entry points, GL 1.5 and later
+static PFNGLGENBUFFERSPROC genBuffers;
+static PFNGLDELETEBUFFERSPROC deleteBuffers;
+static PFNGLBINDBUFFERPROC bindBuffer;
+static PFNGLBUFFERDATAPROC bufferData;
+static PFNGLMAPBUFFERPROC mapBuffer;
+static PFNGLUNMAPBUFFERPROC unmapBuffer;
+
+frameReadback::frameReadback(sf::RenderTexture &texture, std::FILE *out,
+                             std::size_t depth)
+    : texture(texture), size(texture.getSize()), out(out),
+      buffers(std::max<std::size_t>(depth, 1)) {}
+
+frameReadback::~frameReadback() {
+    if (this->pixelBuffers.value_or(false) && this->texture.setActive(true))
+        deleteBuffers(this->buffers.size(), this->buffers.data());
+}
+
+/**
+ * Done on the first frame rather than in the constructor, the texture may
+ * not have a context until then.
+ */
+bool frameReadback::initialize() {
+    auto load = [](auto &function, const char *name) {
+        function =
+            reinterpret_cast<std::remove_reference_t<decltype(function)>>(
+                sf::Context::getFunction(name));
+        return function != nullptr;
+    };
+    bool available =
+        sf::Context::isExtensionAvailable("GL_ARB_pixel_buffer_object") &&
+        load(genBuffers, "glGenBuffers") &&
+        load(deleteBuffers, "glDeleteBuffers") &&
+        load(bindBuffer, "glBindBuffer") && load(bufferData, "glBufferData") &&
+        load(mapBuffer, "glMapBuffer") && load(unmapBuffer, "glUnmapBuffer");
+    if (available) {
+        genBuffers(this->buffers.size(), this->buffers.data());
+        for (auto buffer : this->buffers) {
+            bindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+            bufferData(GL_PIXEL_PACK_BUFFER, this->size.x * this->size.y * 4,
+                       nullptr, GL_STREAM_READ);
+        }
+        bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+    return available;
+}
+
+bool frameReadback::push() {
+    this->texture.display();
+
+    if (!this->pixelBuffers) {
+        if (!this->texture.setActive(true))
+            return false;
+        this->pixelBuffers = this->initialize();
+    }
+    if (!*this->pixelBuffers) {
+        auto image = this->texture.getTexture().copyToImage();
+        auto bytes = std::size_t(this->size.x) * this->size.y * 4;
+        return std::fwrite(image.getPixelsPtr(), 1, bytes, this->out) == bytes;
+    }
+
+    if (!this->texture.setActive(true))
+        return false;
+    auto slot = this->pushed % this->buffers.size();
+    // the slot still holds the oldest frame in flight
+    if (this->pushed - this->written == this->buffers.size() &&
+        !this->writeBuffer(slot))
+        return false;
+
+    bindBuffer(GL_PIXEL_PACK_BUFFER, this->buffers[slot]);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, this->size.x, this->size.y, GL_RGBA, GL_UNSIGNED_BYTE,
+                 nullptr);
+    bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    this->pushed++;
+    return true;
+}
+
+bool frameReadback::finish() {
+    bool ok = true;
+    if (this->pixelBuffers.value_or(false) && this->written < this->pushed) {
+        ok = this->texture.setActive(true);
+        while (ok && this->written < this->pushed)
+            ok = this->writeBuffer(this->written % this->buffers.size());
+    }
+    return std::fflush(this->out) == 0 && ok;
+}
+
+bool frameReadback::writeBuffer(std::size_t slot) {
+    bindBuffer(GL_PIXEL_PACK_BUFFER, this->buffers[slot]);
+    auto pixels = static_cast<const char *>(
+        mapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
+    bool ok = pixels != nullptr;
+    // OpenGL rows go bottom-up
+    std::size_t stride = std::size_t(this->size.x) * 4;
+    for (auto row = this->size.y; ok && row-- > 0;)
+        ok = std::fwrite(pixels + row * stride, 1, stride, this->out) == stride;
+    if (pixels)
+        unmapBuffer(GL_PIXEL_PACK_BUFFER);
+    bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    this->written++;
+    return ok;
+}
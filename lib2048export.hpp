@@ -0,0 +1,63 @@
+#include "lib2048core.hpp"
+#include <SFML/Graphics.hpp>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <vector>
+
+#ifndef _2048EXPORT
+#define _2048EXPORT
+
+/**
+ * A recorded game: the arguments given to gameState, then every move.
+ *
+ * In text form, `#` starting a comment:
+ *
+ *   4 1234567890
+ *   URDLLURD...
+ *
+ * U, R, D and L are moves, N restarts and G generates a tile, whitespace
+ * between moves being ignored.
+ */
+struct replay {
+    gameSize size;
+    std::uint64_t seed;
+    std::vector<gameMovement> moves;
+};
+
+std::optional<replay> loadReplay(const std::string &path);
+
+/**
+ * Streams the frames of a render texture as raw, top-down RGBA.
+ *
+ * Pixels are read into a ring of pixel buffer objects and only mapped
+ * `depth - 1` frames later, so the GPU (or llvmpipe) never has to finish a
+ * frame before the next one is drawn. Without pixel buffer objects every
+ * frame is copied synchronously instead.
+ */
+class frameReadback {
+  public:
+    frameReadback(sf::RenderTexture &, std::FILE *out, std::size_t depth = 4);
+    frameReadback(const frameReadback &) = delete;
+    frameReadback &operator=(const frameReadback &) = delete;
+    ~frameReadback();
+
+    // queue the current contents of the texture
+    bool push();
+    // write every frame still in flight
+    bool finish();
+
+  private:
+    // the buffers live in the texture's context, activated around every call
+    sf::RenderTexture &texture;
+    sf::Vector2u size;
+    std::FILE *out;
+    std::vector<unsigned int> buffers;
+    std::size_t pushed = 0, written = 0;
+    std::optional<bool> pixelBuffers;
+
+    bool initialize();
+    bool writeBuffer(std::size_t slot);
+};
+
+#endif
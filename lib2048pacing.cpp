@@ -0,0 +1,63 @@
+#include "lib2048pacing.hpp"
+#include <algorithm>
+#include <thread>
+#include <utility>
+
+using namespace std::chrono_literals;
+
+framePacer::framePacer(unsigned int refreshRate, unsigned int backgroundRate)
+    : refreshRate(std::max(refreshRate, 1u)),
+      backgroundRate(std::max(backgroundRate, 1u)) {}
+
+void framePacer::setCap(unsigned int fps) { this->cap = fps; }
+
+unsigned int framePacer::rateFor(frameDemand demand) const {
+    auto animating = this->cap ? this->cap : this->refreshRate;
+    switch (demand) {
+    case frameDemand::Background:
+        return std::min(this->backgroundRate, animating);
+    case frameDemand::Interactive:
+        return std::min(this->refreshRate, animating);
+    default:
+        return animating;
+    }
+}
+
+void framePacer::wait(frameDemand demand) {
+    auto now = clock::now();
+    if (this->deadline == clock::time_point()) {
+        this->deadline = now;
+        return;
+    }
+    this->current.frames++;
+
+    auto next = this->deadline +
+                std::chrono::duration_cast<clock::duration>(1s) /
+                    this->rateFor(demand);
+    if (now > next) {
+        // start over from now rather than rushing frames to catch up
+        this->current.missed++;
+        this->current.worstLateness =
+            std::max(this->current.worstLateness, now - next);
+        this->deadline = now;
+        return;
+    }
+
+    if (next - now > this->spinMargin) {
+        auto wake = next - this->spinMargin;
+        std::this_thread::sleep_until(wake);
+        // widen at once after an oversleep, narrow back slowly
+        auto overshoot = clock::now() - wake;
+        this->spinMargin = std::clamp<clock::duration>(
+            std::max<clock::duration>(overshoot * 5 / 4,
+                                      this->spinMargin * 15 / 16),
+            200us, 4ms);
+    }
+    while (clock::now() < next)
+        std::this_thread::yield();
+    this->deadline = next;
+}
+
+framePacer::report framePacer::collect() {
+    return std::exchange(this->current, report());
+}
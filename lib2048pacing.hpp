@@ -0,0 +1,46 @@
+#include <chrono>
+#include <cstdint>
+
+#ifndef _2048PACING
+#define _2048PACING
+
+// what the next frame has to show, from least to most motion
+enum class frameDemand { Background, Interactive, Animating };
+
+/**
+ * Schedules frames against fixed deadlines rather than sleeping after each
+ * one, so the time between frames stays even.
+ *
+ * The rate follows the demand of the next frame: a few frames per second in
+ * the background, the display refresh while the player may press a key (keys
+ * are sampled once per frame) and the frame rate cap while something moves.
+ * Waiting sleeps until shortly before the deadline and spins the rest, the
+ * margin following how late the system actually wakes sleepers up.
+ */
+class framePacer {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    struct report {
+        std::uint64_t frames = 0, missed = 0;
+        clock::duration worstLateness{};
+    };
+
+    explicit framePacer(unsigned int refreshRate = 60,
+                        unsigned int backgroundRate = 10);
+
+    // 0 animates at the display refresh rate
+    void setCap(unsigned int fps);
+    unsigned int rateFor(frameDemand) const;
+    void wait(frameDemand);
+    // statistics since the last call
+    report collect();
+
+  private:
+    unsigned int refreshRate, backgroundRate, cap = 0;
+    clock::time_point deadline;
+    clock::duration spinMargin = std::chrono::milliseconds(1);
+    report current;
+};
+
+#endif
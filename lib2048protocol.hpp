@@ -0,0 +1,119 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#ifndef _2048PROTOCOL
+#define _2048PROTOCOL
+
+/**
+ * Wire format of 2048d. Integers are in host byte order, both ends sharing
+ * the machine through a Unix domain socket.
+ *
+ * Every frame starts with a std::uint32_t holding the length of the bytes
+ * that follow, then a request opcode or a response status and the payload:
+ *
+ *   NewGame    u8 size, u64 seed          -> u32 session
+ *   Move       u32 session, u8 move       -> u8 flags, i64 score
+ *   GetBoard   u32 session                -> u8 size, u8 flags, i64 score,
+ *                                            size * size x u8 exponent
+ *   MoveBatch  u32 session, u16 count,    -> u16 changed, u8 flags, i64 score
+ *              count x u8 move
+ *   EndGame    u32 session                -> nothing
+ *
+ * Sizes are those of GAME_SIZES and moves use the values of gameMovement.
+ * Requests are answered in order, so clients may pipeline as many as they
+ * like before reading.
+ */
+enum class requestType : std::uint8_t {
+    NewGame = 1,
+    Move,
+    GetBoard,
+    MoveBatch,
+    EndGame
+};
+
+enum class responseStatus : std::uint8_t { Ok = 0, UnknownSession, BadRequest };
+
+namespace moveFlags {
+constexpr std::uint8_t Changed = 1, Generated = 2, Lost = 4;
+}
+
+constexpr const char *DEFAULT_SOCKET_PATH = "/tmp/2048d.sock";
+constexpr std::size_t MAX_FRAME_SIZE = 1 << 16;
+
+/**
+ * Appends one frame to a buffer, its length being filled in on destruction.
+ */
+class frameWriter {
+  public:
+    frameWriter(std::vector<char> &out, std::uint8_t head)
+        : out(out), start(out.size()) {
+        this->put<std::uint32_t>(0).put(head);
+    }
+    frameWriter(const frameWriter &) = delete;
+    ~frameWriter() {
+        std::uint32_t length = this->out.size() - this->start - sizeof(length);
+        std::memcpy(this->out.data() + this->start, &length, sizeof(length));
+    }
+
+    template <typename T> frameWriter &put(T value) {
+        auto bytes = reinterpret_cast<const char *>(&value);
+        this->out.insert(this->out.end(), bytes, bytes + sizeof(T));
+        return *this;
+    }
+
+  private:
+    std::vector<char> &out;
+    std::size_t start;
+};
+
+/**
+ * Reads the fields of a frame payload, failing once it runs out of bytes.
+ */
+class frameReader {
+  public:
+    frameReader(const char *data, std::size_t size)
+        : cursor(data), end(data + size) {}
+
+    template <typename T> bool get(T &value) {
+        if (std::size_t(this->end - this->cursor) < sizeof(T))
+            return false;
+        std::memcpy(&value, this->cursor, sizeof(T));
+        this->cursor += sizeof(T);
+        return true;
+    }
+    const char *data() const { return this->cursor; }
+    std::size_t remaining() const { return this->end - this->cursor; }
+    void skip(std::size_t count) { this->cursor += count; }
+
+  private:
+    const char *cursor, *end;
+};
+
+/**
+ * Splits complete frames off the front of a buffer, leaving a partial one
+ * for the next read. Returns false on a frame larger than MAX_FRAME_SIZE.
+ */
+template <typename Handler>
+bool forEachFrame(std::vector<char> &buffer, Handler &&handler) {
+    std::size_t offset = 0;
+    bool valid = true;
+    while (buffer.size() - offset >= sizeof(std::uint32_t)) {
+        std::uint32_t length;
+        std::memcpy(&length, buffer.data() + offset, sizeof(length));
+        if (length == 0 || length > MAX_FRAME_SIZE) {
+            valid = false;
+            break;
+        }
+        if (buffer.size() - offset - sizeof(length) < length)
+            break;
+        offset += sizeof(length);
+        handler(frameReader(buffer.data() + offset, length));
+        offset += length;
+    }
+    buffer.erase(buffer.begin(), buffer.begin() + offset);
+    return valid;
+}
+
+#endif
@@ -0,0 +1,417 @@
+#include "lib2048render.hpp"
+#include <SFML/OpenGL.hpp>
+#include <algorithm>
+#include <cmath>
+
+sceneLayout::sceneLayout(sf::Vector2u windowSize, gameSize boardSize)
+    : windowSize(windowSize), boardSize(boardSize) {
+    unsigned int baseDimension = std::min(windowSize.x, windowSize.y);
+    this->matrixSide = baseDimension / 4 * 3;
+    this->baseX = (windowSize.x - this->matrixSide) >> 1;
+    this->baseY = (windowSize.y - this->matrixSide) >> 1;
+    this->cellSide = this->matrixSide / boardSize;
+    this->borderSize = this->cellSide / 8;
+    this->cellSide -= this->borderSize;
+    this->renderCellSide = this->cellSide + cellOutlineThickness * 2;
+    this->fontSize = float(this->cellSide) / 2.5;
+    this->scoreSize =
+        sf::Vector2u(windowSize.x / 10 * 2, windowSize.y / 20 * 2);
+}
+
+sf::Color getCellColor(const gameConfig &config, gameValue value) {
+    sf::Color _;
+    const auto &entry = config.cellColors[exponentOf(value)];
+    if (entry.present)
+        _ = sf::Color(entry.r, entry.g, entry.b, entry.a);
+    else
+        _ = sf::Color(0xFF, 0xFF, 0xFF, 160);
+    if (value)
+        _.a = 180 + (uint8_t)((log2(value) / log2(2048)) * 75);
+    return _;
+}
+
+sf::Color getTextColor(const gameConfig &config, gameValue value) {
+    auto index = exponentOf(value);
+    const auto &entry = config.textColors[index];
+    if (config.cellColors[index].present && entry.present)
+        return sf::Color(entry.r, entry.g, entry.b, entry.a);
+    return sf::Color(0, 0, 0);
+}
+
+void drawCell(sf::RenderTarget &target, const gameConfig &config,
+              const sf::Font &font, gameValue value, const sceneLayout &layout,
+              sf::Vector2f position) {
+    auto cellSide = layout.cellSide;
+
+    sf::RectangleShape box;
+    box.setPosition(position.x + cellOutlineThickness,
+                    position.y +
+                        cellOutlineThickness); // the outline seems to be drawn
+                                               // around the box itself, and not
+                                               // counted in the main rectangle
+    box.setOutlineColor(sf::Color(255, 255, 255, 255));
+    box.setOutlineThickness(cellOutlineThickness);
+    box.setSize(sf::Vector2f(cellSide, cellSide));
+    box.setFillColor(getCellColor(config, value));
+    target.draw(box);
+
+    // render the text
+    sf::Text text(value ? std::to_string(value) : "", font, layout.fontSize);
+    auto textBoundaryBox = text.getGlobalBounds();
+    // place the number in the center
+    text.setOrigin(
+        (textBoundaryBox.width - cellSide) / 2 + textBoundaryBox.left,
+        (textBoundaryBox.height - cellSide) / 2 + textBoundaryBox.top);
+    text.setPosition(position.x, position.y);
+    text.setFillColor(getTextColor(config, value));
+    target.draw(text);
+}
+
+void drawScore(sf::RenderTarget &target, textLine &text, gameValue score,
+               const sceneLayout &layout) {
+    auto width = layout.scoreSize.x, height = layout.scoreSize.y;
+    auto left = layout.windowSize.x / 2.f - width / 2.f,
+         top = layout.windowSize.y / 15.f - height / 2.f;
+
+    sf::RectangleShape box;
+    box.setPosition(left, top);
+    box.setOutlineColor(sf::Color::Black);
+    box.setOutlineThickness(cellOutlineThickness);
+    box.setSize(sf::Vector2f(width, height));
+    box.setFillColor(sf::Color::Transparent);
+    target.draw(box);
+
+    // only lays the glyphs out again when the score has changed
+    text.setString(std::to_string(score));
+    auto textBoundaryBox = text.getLocalBounds();
+    text.setOrigin((textBoundaryBox.width - width) / 2 + textBoundaryBox.left,
+                   (textBoundaryBox.height - height) / 2 + textBoundaryBox.top);
+    text.setPosition(left, top);
+    text.setFillColor(sf::Color::Black);
+    target.draw(text);
+}
+
+void drawPausingScreen(sf::RenderTarget &target, const sf::Font &font,
+                       std::string_view status, const sceneLayout &layout) {
+    auto windowSize = sf::Vector2f(layout.windowSize);
+
+    sf::RectangleShape _;
+    _.setSize(windowSize);
+    _.setFillColor(sf::Color(0xFF, 0xFF, 0xFF, 230));
+    _.setPosition(0, 0);
+
+    sf::Text pausedText(std::string(status), font, 50);
+    auto textBoundaryBox = pausedText.getGlobalBounds();
+    pausedText.setPosition(windowSize.x / 2 - textBoundaryBox.width / 2,
+                           windowSize.y / 2 - textBoundaryBox.height / 2);
+    pausedText.setFillColor(sf::Color::Black);
+
+    target.draw(_);
+    target.draw(pausedText);
+}
+
+void drawCooldown(sf::RenderTarget &target, const sceneLayout &layout,
+                  float remaining) {
+    auto height = float(layout.windowSize.y) * remaining;
+    sf::RectangleShape cooldown(sf::Vector2f(layout.windowSize.x, height));
+    auto fill = sf::Color::White;
+    fill.a = 103;
+    cooldown.setFillColor(fill);
+    cooldown.setPosition(0, layout.windowSize.y - height);
+    target.draw(cooldown);
+}
+
+void drawBoard(sf::RenderTarget &target, tileAtlas &atlas,
+               const gameState &game, const sceneLayout &layout) {
+    auto &matrix = game.matrix;
+    for (gameSize rowIndex = 0; rowIndex < matrix.size(); rowIndex++)
+        for (gameSize cellIndex = 0; cellIndex < matrix[rowIndex].size();
+             cellIndex++) {
+            auto cellSprite = atlas.cell(matrix[rowIndex][cellIndex], layout);
+            cellSprite.setPosition(
+                layout.baseX +
+                    cellIndex * (layout.renderCellSide + layout.borderSize),
+                layout.baseY +
+                    rowIndex * (layout.renderCellSide + layout.borderSize));
+            target.draw(cellSprite);
+        }
+}
+
+void drawScan(sf::RenderTarget &target, const sceneLayout &layout,
+              gameMovement lastMovement, int elapsedMsec, int scanTimeMsec,
+              float scanWidthMultiplier) {
+    auto matrixSide = layout.matrixSide, baseX = layout.baseX,
+         baseY = layout.baseY;
+    auto scanCoverage = layout.renderCellSide * layout.boardSize +
+                        (layout.boardSize - 1) * layout.borderSize;
+    auto scanWidth = scanCoverage * scanWidthMultiplier;
+    bool increment = true;
+    gameSize from = 0, to = scanWidth;
+    auto progress = float(scanTimeMsec - elapsedMsec) / scanTimeMsec;
+    switch (lastMovement) {
+    case gameMovement::Down:
+    case gameMovement::Right:
+        increment = false;
+        from = scanWidth, to = 0;
+        progress = 1 - progress;
+        [[fallthrough]];
+    case gameMovement::Up:
+    case gameMovement::Left: {
+        for (auto i = from; (from > to ? i > to : i < to);
+             increment ? i++ : i--) {
+            auto y = baseY + progress * matrixSide + (matrixSide / 2) -
+                     scanWidth + 1 + i;
+            auto x = baseX + progress * matrixSide + (matrixSide / 2) -
+                     scanWidth + 1 + i;
+            sf::RectangleShape scan;
+            auto c = sf::Color::White;
+            const int maximumAlpha = 128;
+            if (lastMovement == gameMovement::Up ||
+                lastMovement == gameMovement::Down) {
+                if (y < baseY || y > baseY + scanCoverage)
+                    continue;
+                scan.setSize(sf::Vector2f(scanCoverage, 1));
+                scan.setPosition(baseX, y);
+                c.a = maximumAlpha *
+                      ((lastMovement == gameMovement::Up ? 1 - float(i + 1)
+                                                         : float(i + 1)) /
+                       scanWidth);
+            }
+
+            if (lastMovement == gameMovement::Left ||
+                lastMovement == gameMovement::Right) {
+                if (x < baseX || x > baseX + scanCoverage)
+                    continue;
+                scan.setSize(sf::Vector2f(1, scanCoverage));
+                scan.setPosition(x, baseY);
+                c.a = maximumAlpha *
+                      ((lastMovement == gameMovement::Left ? 1 - float(i + 1)
+                                                           : float(i + 1)) /
+                       scanWidth);
+            }
+
+            scan.setFillColor(c);
+            target.draw(scan);
+        }
+    }
+    default:
+        break;
+    };
+}
+
+/**
+ * Grow a pooled surface to fit at least the given size. Sizes are rounded up
+ * so that dragging the window edge does not recreate it on every event.
+ */
+static bool reserve(sf::RenderTexture &surface, sf::Vector2u size) {
+    const unsigned int granularity = 256;
+    if (!size.x || !size.y)
+        return false;
+    auto current = surface.getSize();
+    if (current.x >= size.x && current.y >= size.y)
+        return true;
+    auto roundUp = [granularity](unsigned int value) {
+        return (value + granularity - 1) / granularity * granularity;
+    };
+    return surface.create(roundUp(std::max(current.x, size.x)),
+                          roundUp(std::max(current.y, size.y)));
+}
+
+// grid holding every tile up to `highest`, rendering at least up to 2048
+static sf::Vector2u gridSize(const sceneLayout &layout, gameValue highest) {
+    auto rows = exponentOf(std::max<gameValue>(highest, 2048)) /
+                    atlasGeneration::columns +
+                1;
+    return sf::Vector2u(layout.renderCellSide * atlasGeneration::columns,
+                        layout.renderCellSide * rows);
+}
+
+bool atlasGeneration::prepare(const sceneLayout &layout, gameValue highest) {
+    this->rendered.reset();
+    this->overlayStatus = {};
+    this->layout.reset();
+
+    if (!reserve(this->cells, gridSize(layout, highest)) ||
+        !reserve(this->overlay, layout.windowSize))
+        return false;
+    this->layout = layout;
+    return true;
+}
+
+sf::IntRect atlasGeneration::cellRect(gameValue value) const {
+    auto index = exponentOf(value);
+    int side = this->layout->renderCellSide;
+    return sf::IntRect(index % columns * side, index / columns * side, side,
+                       side);
+}
+
+void atlasGeneration::renderCell(const gameConfig &config, const sf::Font &font,
+                                 gameValue value) {
+    // growing recreates the surface, the other tiles are rendered again
+    // when next asked for
+    auto size = gridSize(*this->layout, value);
+    if (this->cells.getSize().y < size.y) {
+        if (!reserve(this->cells, size))
+            return;
+        this->rendered.reset();
+    }
+    auto rect = this->cellRect(value);
+
+    // wipe only this slot, other tiles of the atlas stay untouched
+    sf::RectangleShape slot(sf::Vector2f(rect.width, rect.height));
+    slot.setPosition(rect.left, rect.top);
+    slot.setFillColor(sf::Color::Black);
+    this->cells.draw(slot, sf::BlendNone);
+
+    drawCell(this->cells, config, font, value, *this->layout,
+             sf::Vector2f(rect.left, rect.top));
+    this->cells.display();
+    this->rendered.set(exponentOf(value));
+}
+
+void atlasGeneration::renderOverlay(const sf::Font &font,
+                                    std::string_view status) {
+    this->overlay.clear(sf::Color::Transparent);
+    drawPausingScreen(this->overlay, font, status, *this->layout);
+    this->overlay.display();
+    this->overlayStatus = status;
+}
+
+tileAtlas::tileAtlas(const gameConfig &config, const sf::Font &latoBold,
+                     const sf::Font &montserratRegular,
+                     assetData latoBoldData, assetData montserratRegularData)
+    : config(config), latoBold(latoBold),
+      montserratRegular(montserratRegular), latoBoldData(latoBoldData),
+      montserratRegularData(montserratRegularData) {}
+
+tileAtlas::~tileAtlas() {
+    {
+        std::lock_guard lock(this->mutex);
+        this->stopping = true;
+    }
+    this->wake.notify_one();
+    if (this->worker.joinable())
+        this->worker.join();
+}
+
+void tileAtlas::rebuild(request job) {
+    {
+        std::lock_guard lock(this->mutex);
+        // started on demand, an atlas never resized needs no second context
+        if (!this->worker.joinable())
+            this->worker = std::thread(&tileAtlas::work, this);
+        job.serial = ++this->serial;
+        this->pending = std::move(job);
+    }
+    this->wake.notify_one();
+}
+
+void tileAtlas::poll() {
+    {
+        std::lock_guard lock(this->mutex);
+        if (!this->finished)
+            return;
+    }
+    // the old front goes to the worker, which redraws it from its own
+    // context: the draws of the last frames reading it have to be done first
+    glFinish();
+
+    std::lock_guard lock(this->mutex);
+    this->spare = std::move(this->front);
+    this->front = std::move(this->finished);
+
+    // the worker may have used a palette older than the last reload
+    if (this->front->serial < this->invalidatedAfter)
+        this->front->rendered &= ~this->invalidated;
+    else
+        this->invalidated.reset();
+}
+
+void tileAtlas::invalidate(std::bitset<64> exponents) {
+    if (this->front)
+        this->front->rendered &= ~exponents;
+    std::lock_guard lock(this->mutex);
+    this->invalidated |= exponents;
+    this->invalidatedAfter = this->serial + 1;
+}
+
+void tileAtlas::work() {
+    // sf::Font is not thread-safe, the worker keeps its own instances
+    sf::Context context;
+    sf::Font latoBold, montserratRegular;
+    latoBold.loadFromMemory(this->latoBoldData.data(),
+                            this->latoBoldData.size());
+    montserratRegular.loadFromMemory(this->montserratRegularData.data(),
+                                     this->montserratRegularData.size());
+
+    std::unique_lock lock(this->mutex);
+    while (true) {
+        this->wake.wait(lock,
+                        [this] { return this->stopping || this->pending; });
+        if (this->stopping)
+            return;
+        auto job = std::move(*this->pending);
+        this->pending.reset();
+        auto target = this->spare ? std::move(this->spare)
+                                  : std::make_unique<atlasGeneration>();
+        lock.unlock();
+
+        if (target->prepare(job.layout, job.highest)) {
+            target->serial = job.serial;
+            auto highest = exponentOf(std::max<gameValue>(job.highest, 2048));
+            for (std::size_t exponent = 0; exponent <= highest; exponent++)
+                target->renderCell(job.config, montserratRegular,
+                                   exponent ? gameValue(1) << exponent : 0);
+            target->renderOverlay(latoBold, job.status);
+            // complete the result before the render loop's context samples it
+            glFinish();
+        }
+
+        lock.lock();
+        if (!target->layout) {
+            this->spare = std::move(target);
+            continue;
+        }
+        if (this->finished)
+            this->spare = std::move(this->finished);
+        this->finished = std::move(target);
+    }
+}
+
+atlasGeneration &tileAtlas::current(const sceneLayout &layout) {
+    if (!this->front)
+        this->front = std::make_unique<atlasGeneration>();
+    if (!this->front->layout)
+        this->front->prepare(layout, 0);
+    return *this->front;
+}
+
+sf::Sprite tileAtlas::cell(gameValue value, const sceneLayout &layout) {
+    auto &generation = this->current(layout);
+    if (!generation.layout)
+        return sf::Sprite();
+    if (!generation.rendered[exponentOf(value)])
+        generation.renderCell(this->config, this->montserratRegular, value);
+
+    sf::Sprite sprite(generation.cells.getTexture(),
+                      generation.cellRect(value));
+    auto scale =
+        float(layout.renderCellSide) / generation.layout->renderCellSide;
+    sprite.setScale(scale, scale);
+    return sprite;
+}
+
+sf::Sprite tileAtlas::overlay(std::string_view status,
+                              const sceneLayout &layout) {
+    auto &generation = this->current(layout);
+    if (!generation.layout)
+        return sf::Sprite();
+    if (generation.overlayStatus != status)
+        generation.renderOverlay(this->latoBold, status);
+
+    auto from = generation.layout->windowSize, to = layout.windowSize;
+    sf::Sprite sprite(generation.overlay.getTexture(),
+                      sf::IntRect(0, 0, from.x, from.y));
+    sprite.setScale(float(to.x) / from.x, float(to.y) / from.y);
+    return sprite;
+}
@@ -0,0 +1,136 @@
+#include "lib2048assets.hpp"
+#include "lib2048core.hpp"
+#include "lib2048text.hpp"
+#include <SFML/Graphics.hpp>
+#include <bitset>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#ifndef _2048RENDER
+#define _2048RENDER
+
+constexpr int cellOutlineThickness = 1;
+
+/**
+ * Pixel geometry of the scene for a given window and board size.
+ *
+ * The game field is centered in the window, its side being 75% of the
+ * smaller window dimension.
+ */
+struct sceneLayout {
+    sf::Vector2u windowSize;
+    gameSize boardSize;
+    unsigned int matrixSide, baseX, baseY, cellSide, borderSize,
+        renderCellSide;
+    float fontSize;
+    sf::Vector2u scoreSize;
+
+    sceneLayout(sf::Vector2u windowSize, gameSize boardSize);
+};
+
+sf::Color getCellColor(const gameConfig &, gameValue);
+sf::Color getTextColor(const gameConfig &, gameValue);
+
+void drawCell(sf::RenderTarget &, const gameConfig &, const sf::Font &,
+              gameValue, const sceneLayout &, sf::Vector2f position);
+void drawScore(sf::RenderTarget &, textLine &, gameValue, const sceneLayout &);
+void drawPausingScreen(sf::RenderTarget &, const sf::Font &, std::string_view,
+                       const sceneLayout &);
+
+class tileAtlas;
+
+// `remaining` is the fraction of the cooldown left, from 1 down to 0
+void drawCooldown(sf::RenderTarget &, const sceneLayout &, float remaining);
+/**
+ * Game field
+ *
+ * The game field will be centered in the window horizontally.
+ * Width and height should be 75% of the window width/height.
+ * Should they be different, the minimum of two will be used.
+ */
+void drawBoard(sf::RenderTarget &, tileAtlas &, const gameState &,
+               const sceneLayout &);
+// sweep across the board following the last move
+void drawScan(sf::RenderTarget &, const sceneLayout &,
+              gameMovement lastMovement, int elapsedMsec, int scanTimeMsec,
+              float scanWidthMultiplier);
+
+/**
+ * One set of offscreen surfaces holding the pre-rendered tiles and overlay of
+ * the scene at a given layout.
+ *
+ * Tiles live in a single grid indexed by the exponent of their value, with
+ * as many rows as the highest tile needs. The surfaces are only recreated
+ * when a layout or a new highest tile outgrows them, so a generation can be
+ * re-rendered many times while the window is being resized.
+ */
+struct atlasGeneration {
+    static constexpr unsigned int columns = 4;
+
+    std::optional<sceneLayout> layout;
+    std::uint64_t serial = 0;
+    sf::RenderTexture cells, overlay;
+    std::bitset<64> rendered;
+    std::string_view overlayStatus;
+
+    bool prepare(const sceneLayout &, gameValue highest);
+    sf::IntRect cellRect(gameValue) const;
+    void renderCell(const gameConfig &, const sf::Font &, gameValue);
+    void renderOverlay(const sf::Font &, std::string_view);
+};
+
+/**
+ * Double-buffered tile and overlay textures.
+ *
+ * Layout changes are handed to a worker thread owning its own GL context and
+ * fonts. Until the worker publishes the new generation, the previous one is
+ * drawn scaled to the requested layout.
+ */
+class tileAtlas {
+  public:
+    struct request {
+        sceneLayout layout;
+        gameConfig config;
+        gameValue highest;
+        std::string_view status;
+        std::uint64_t serial = 0;
+    };
+
+    tileAtlas(const gameConfig &, const sf::Font &latoBold,
+              const sf::Font &montserratRegular, assetData latoBoldData,
+              assetData montserratRegularData);
+    ~tileAtlas();
+
+    void rebuild(request);
+    void poll();
+    // forget the tiles whose colours changed, see gameConfig::difference
+    void invalidate(std::bitset<64> exponents);
+
+    sf::Sprite cell(gameValue, const sceneLayout &);
+    sf::Sprite overlay(std::string_view, const sceneLayout &);
+
+  private:
+    const gameConfig &config;
+    const sf::Font &latoBold, &montserratRegular;
+    assetData latoBoldData, montserratRegularData;
+
+    std::unique_ptr<atlasGeneration> front;
+    std::unique_ptr<atlasGeneration> finished, spare;
+    std::optional<request> pending;
+    std::uint64_t serial = 0, invalidatedAfter = 0;
+    std::bitset<64> invalidated;
+    bool stopping = false;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::thread worker;
+
+    void work();
+    atlasGeneration &current(const sceneLayout &);
+};
+
+#endif
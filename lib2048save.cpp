@@ -0,0 +1,161 @@
+#include "lib2048save.hpp"
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static std::uint64_t checksum(const char *data, std::size_t size) {
+    std::uint64_t hash = 0xcbf29ce484222325;
+    for (std::size_t i = 0; i < size; i++) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+template <typename T> static void append(std::vector<char> &out, T value) {
+    auto bytes = reinterpret_cast<const char *>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+std::vector<char> encodeSnapshot(const gameSnapshot &snapshot) {
+    std::vector<char> out(SAVE_MAGIC.begin(), SAVE_MAGIC.end());
+    append<std::uint8_t>(out, snapshot.size);
+    append<std::uint8_t>(out, snapshot.lost);
+    append<std::int64_t>(out, snapshot.score);
+    append<std::uint64_t>(out, snapshot.seed);
+    append<std::uint64_t>(out, snapshot.draws);
+    out.insert(out.end(), snapshot.exponents.begin(), snapshot.exponents.end());
+    append<std::uint64_t>(out, checksum(out.data(), out.size()));
+    return out;
+}
+
+std::optional<gameSnapshot> decodeSnapshot(std::span<const char> data) {
+    const std::size_t header = SAVE_MAGIC.size() + 2 + 3 * 8, trailer = 8;
+    if (data.size() < header + trailer ||
+        std::string_view(data.data(), SAVE_MAGIC.size()) != SAVE_MAGIC)
+        return std::nullopt;
+
+    std::uint64_t stored;
+    std::memcpy(&stored, data.data() + data.size() - trailer, trailer);
+    if (stored != checksum(data.data(), data.size() - trailer))
+        return std::nullopt;
+
+    auto cursor = data.data() + SAVE_MAGIC.size();
+    auto read = [&cursor](auto &value) {
+        std::memcpy(&value, cursor, sizeof(value));
+        cursor += sizeof(value);
+    };
+    std::uint8_t size, lost;
+    gameSnapshot snapshot;
+    read(size);
+    read(lost);
+    read(snapshot.score);
+    read(snapshot.seed);
+    read(snapshot.draws);
+    if (size < 2 || data.size() != header + size * size + trailer)
+        return std::nullopt;
+    snapshot.size = size;
+    snapshot.lost = lost;
+    snapshot.exponents.assign(cursor, cursor + size * size);
+    for (auto exponent : snapshot.exponents)
+        if (exponent >= 63)
+            return std::nullopt;
+    return snapshot;
+}
+
+std::optional<gameSnapshot> loadSnapshot(const std::string &path) {
+    auto fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return std::nullopt;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return std::nullopt;
+    }
+    auto mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        return std::nullopt;
+    auto snapshot = decodeSnapshot(
+        std::span(static_cast<const char *>(mapping), info.st_size));
+    munmap(mapping, info.st_size);
+    return snapshot;
+}
+
+autosaver::autosaver(std::string path, std::chrono::milliseconds interval)
+    : path(std::move(path)), interval(interval),
+      worker(&autosaver::work, this) {}
+
+autosaver::~autosaver() {
+    {
+        std::lock_guard lock(this->mutex);
+        this->stopping = true;
+    }
+    this->wake.notify_one();
+    this->worker.join();
+}
+
+void autosaver::submit(gameSnapshot snapshot) {
+    {
+        std::lock_guard lock(this->mutex);
+        this->pending = std::move(snapshot);
+    }
+    this->wake.notify_one();
+}
+
+void autosaver::work() {
+    std::unique_lock lock(this->mutex);
+    while (true) {
+        this->wake.wait(lock,
+                        [this] { return this->stopping || this->pending; });
+        if (!this->pending)
+            return;
+        auto snapshot = std::move(*this->pending);
+        this->pending.reset();
+        lock.unlock();
+
+        this->write(snapshot);
+        auto next = std::chrono::steady_clock::now() + this->interval;
+
+        // whatever is submitted meanwhile goes into the next write
+        lock.lock();
+        this->wake.wait_until(lock, next, [this] { return this->stopping; });
+    }
+}
+
+bool autosaver::write(const gameSnapshot &snapshot) {
+    auto data = encodeSnapshot(snapshot);
+    auto temporary = this->path + ".tmp";
+
+    auto fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                   0644);
+    if (fd < 0)
+        return false;
+    std::size_t written = 0;
+    while (written < data.size()) {
+        auto length = ::write(fd, data.data() + written, data.size() - written);
+        if (length <= 0) {
+            close(fd);
+            return false;
+        }
+        written += length;
+    }
+    // the data has to be on disk before the rename makes it the save
+    bool synced = fsync(fd) == 0;
+    close(fd);
+    if (!synced || rename(temporary.c_str(), this->path.c_str()) != 0)
+        return false;
+
+    // and the rename itself has to reach the directory
+    auto directory = std::filesystem::path(this->path).parent_path();
+    auto directoryFd = open(directory.empty() ? "." : directory.c_str(),
+                            O_RDONLY | O_DIRECTORY);
+    if (directoryFd >= 0) {
+        fsync(directoryFd);
+        close(directoryFd);
+    }
+    return true;
+}
@@ -0,0 +1,62 @@
+#include "lib2048core.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _2048SAVE
+#define _2048SAVE
+
+/**
+ * Save file layout, integers in host byte order:
+ *
+ *   char          magic[8]
+ *   std::uint8_t  size, lost
+ *   std::int64_t  score
+ *   std::uint64_t seed, draws
+ *   std::uint8_t  exponents[size * size]
+ *   std::uint64_t checksum, FNV-1a of everything before it
+ */
+constexpr std::string_view SAVE_MAGIC{"2048SAV\1", 8};
+
+std::vector<char> encodeSnapshot(const gameSnapshot &);
+std::optional<gameSnapshot> decodeSnapshot(std::span<const char>);
+// memory-maps the file, nothing is returned when it is missing or damaged
+std::optional<gameSnapshot> loadSnapshot(const std::string &path);
+
+/**
+ * Writes snapshots from a background thread.
+ *
+ * Only the latest snapshot is kept, and writes are at least `interval`
+ * apart. Several moves therefore cost a single write, fsync and rename. The
+ * file is replaced atomically, so a crash leaves either the previous save
+ * or the new one. The last submitted snapshot is written on destruction.
+ */
+class autosaver {
+  public:
+    autosaver(std::string path, std::chrono::milliseconds interval =
+                                    std::chrono::milliseconds(250));
+    autosaver(const autosaver &) = delete;
+    autosaver &operator=(const autosaver &) = delete;
+    ~autosaver();
+
+    void submit(gameSnapshot);
+
+  private:
+    std::string path;
+    std::chrono::milliseconds interval;
+    std::optional<gameSnapshot> pending;
+    bool stopping = false;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::thread worker;
+
+    void work();
+    bool write(const gameSnapshot &);
+};
+
+#endif
@@ -0,0 +1,154 @@
+#include "lib2048text.hpp"
+#include <algorithm>
+#include <limits>
+
+void glyphAtlas::build(std::initializer_list<glyphRun> requested) {
+    const unsigned int atlasWidth = 512, padding = 2;
+
+    this->runs.clear();
+    std::vector<sf::Image> pages;
+
+    // shelf-pack every glyph, left to right then top to bottom
+    unsigned int x = 0, y = 0, shelfHeight = 0;
+    for (const auto &request : requested) {
+        auto &run = this->runs.emplace_back();
+        run.font = request.font;
+        run.characterSize = request.characterSize;
+        run.kerning.assign(128 * 128, 0);
+
+        for (unsigned char c : request.characters) {
+            if (c >= 128)
+                continue;
+            const auto &source =
+                request.font->getGlyph(c, request.characterSize, false);
+            auto &entry = run.glyphs[c];
+            entry.present = true;
+            entry.advance = source.advance;
+            entry.bounds = source.bounds;
+            entry.textureRect = source.textureRect;
+
+            auto width = unsigned(source.textureRect.width),
+                 height = unsigned(source.textureRect.height);
+            if (x + width + padding > atlasWidth) {
+                x = 0;
+                y += shelfHeight + padding;
+                shelfHeight = 0;
+            }
+            // remember where the glyph goes, it is copied once the font page
+            // holds every glyph of the run
+            entry.textureRect.left = x;
+            entry.textureRect.top = y;
+            x += width + padding;
+            shelfHeight = std::max(shelfHeight, height);
+        }
+
+        for (unsigned char left : request.characters)
+            for (unsigned char right : request.characters)
+                if (left < 128 && right < 128)
+                    run.kerning[left * 128 + right] = request.font->getKerning(
+                        left, right, request.characterSize);
+
+        pages.push_back(
+            request.font->getTexture(request.characterSize).copyToImage());
+    }
+
+    sf::Image image;
+    image.create(atlasWidth, std::max(1u, y + shelfHeight),
+                 sf::Color::Transparent);
+    for (std::size_t i = 0; i < this->runs.size(); i++) {
+        const auto &run = this->runs[i];
+        for (unsigned char c = 0; c < 128; c++) {
+            const auto &entry = run.glyphs[c];
+            // an empty rectangle would copy the whole page
+            if (!entry.present || !entry.textureRect.width ||
+                !entry.textureRect.height)
+                continue;
+            auto source = run.font->getGlyph(c, run.characterSize, false)
+                              .textureRect;
+            image.copy(pages[i], entry.textureRect.left, entry.textureRect.top,
+                       source);
+        }
+    }
+    this->texture.loadFromImage(image);
+    this->texture.setSmooth(true);
+}
+
+const glyphAtlas::run *glyphAtlas::find(const sf::Font &font,
+                                        unsigned int characterSize) const {
+    for (const auto &run : this->runs)
+        if (run.font == &font && run.characterSize == characterSize)
+            return &run;
+    return nullptr;
+}
+
+const sf::Texture &glyphAtlas::getTexture() const { return this->texture; }
+
+textLine::textLine(const glyphAtlas &atlas, const sf::Font &font,
+                   unsigned int characterSize)
+    : atlas(atlas), run(atlas.find(font, characterSize)) {}
+
+void textLine::setString(std::string_view string) {
+    if (string == this->string)
+        return;
+    this->string = string;
+    this->vertices.clear();
+    this->bounds = sf::FloatRect();
+    if (!this->run)
+        return;
+
+    // same baseline placement as sf::Text
+    float x = 0, y = this->run->characterSize;
+    float minX = std::numeric_limits<float>::max(), minY = minX,
+          maxX = std::numeric_limits<float>::lowest(), maxY = maxX;
+    unsigned char previous = 0;
+    for (unsigned char c : string) {
+        if (c >= 128 || !this->run->glyphs[c].present)
+            continue;
+        const auto &glyph = this->run->glyphs[c];
+        if (previous)
+            x += this->run->kerning[previous * 128 + c];
+        previous = c;
+
+        float left = x + glyph.bounds.left, top = y + glyph.bounds.top,
+              right = left + glyph.bounds.width,
+              bottom = top + glyph.bounds.height;
+        float u1 = glyph.textureRect.left, v1 = glyph.textureRect.top,
+              u2 = u1 + glyph.textureRect.width,
+              v2 = v1 + glyph.textureRect.height;
+
+        this->vertices.append(sf::Vertex(sf::Vector2f(left, top), this->color,
+                                         sf::Vector2f(u1, v1)));
+        this->vertices.append(sf::Vertex(sf::Vector2f(right, top), this->color,
+                                         sf::Vector2f(u2, v1)));
+        this->vertices.append(sf::Vertex(sf::Vector2f(left, bottom),
+                                         this->color, sf::Vector2f(u1, v2)));
+        this->vertices.append(sf::Vertex(sf::Vector2f(left, bottom),
+                                         this->color, sf::Vector2f(u1, v2)));
+        this->vertices.append(sf::Vertex(sf::Vector2f(right, top), this->color,
+                                         sf::Vector2f(u2, v1)));
+        this->vertices.append(sf::Vertex(sf::Vector2f(right, bottom),
+                                         this->color, sf::Vector2f(u2, v2)));
+
+        minX = std::min(minX, left), minY = std::min(minY, top);
+        maxX = std::max(maxX, right), maxY = std::max(maxY, bottom);
+        x += glyph.advance;
+    }
+    if (this->vertices.getVertexCount())
+        this->bounds = sf::FloatRect(minX, minY, maxX - minX, maxY - minY);
+}
+
+void textLine::setFillColor(sf::Color color) {
+    if (color == this->color)
+        return;
+    this->color = color;
+    for (std::size_t i = 0; i < this->vertices.getVertexCount(); i++)
+        this->vertices[i].color = color;
+}
+
+sf::FloatRect textLine::getLocalBounds() const { return this->bounds; }
+
+void textLine::draw(sf::RenderTarget &target, sf::RenderStates states) const {
+    states.transform *= this->getTransform();
+    states.texture = &this->atlas.getTexture();
+    target.draw(this->vertices, states);
+}
@@ -0,0 +1,78 @@
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifndef _2048TEXT
+#define _2048TEXT
+
+constexpr std::string_view DIGITS{"0123456789"};
+constexpr std::string_view PRINTABLE_ASCII{
+    " !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`"
+    "abcdefghijklmnopqrstuvwxyz{|}~"};
+
+/**
+ * A set of characters of a font to pre-rasterise at a given size.
+ */
+struct glyphRun {
+    const sf::Font *font;
+    unsigned int characterSize;
+    std::string_view characters;
+};
+
+/**
+ * Glyphs of several fonts and sizes packed into a single texture.
+ *
+ * Everything is rasterised once in build(), laying out a string afterwards
+ * only reads precomputed metrics, kerning included.
+ */
+class glyphAtlas {
+  public:
+    struct glyph {
+        bool present = false;
+        float advance;
+        sf::FloatRect bounds;
+        sf::IntRect textureRect;
+    };
+    struct run {
+        const sf::Font *font;
+        unsigned int characterSize;
+        std::array<glyph, 128> glyphs;
+        // kerning[left * 128 + right]
+        std::vector<float> kerning;
+    };
+
+    void build(std::initializer_list<glyphRun>);
+    const run *find(const sf::Font &, unsigned int characterSize) const;
+    const sf::Texture &getTexture() const;
+
+  private:
+    std::vector<run> runs;
+    sf::Texture texture;
+};
+
+/**
+ * Single line of text drawn from a glyphAtlas, mirroring the parts of the
+ * sf::Text interface the game uses.
+ */
+class textLine : public sf::Drawable, public sf::Transformable {
+  public:
+    textLine(const glyphAtlas &, const sf::Font &, unsigned int characterSize);
+
+    void setString(std::string_view);
+    void setFillColor(sf::Color);
+    sf::FloatRect getLocalBounds() const;
+
+  private:
+    const glyphAtlas &atlas;
+    const glyphAtlas::run *run;
+    std::string string;
+    sf::Color color = sf::Color::White;
+    sf::VertexArray vertices{sf::Triangles};
+    sf::FloatRect bounds;
+
+    void draw(sf::RenderTarget &, sf::RenderStates) const override;
+};
+
+#endif
@@ -1,4 +1,7 @@
 #include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <charconv>
+#include <iterator>
 #include <string>
 #include <vector>
 
@@ -26,6 +29,16 @@ constexpr auto trim(std::string_view s) {
     return s.substr(front, back + 1 - front);
 }
 
+// parse the whole of `s`, leaving `number` untouched unless it succeeds
+template <class T> bool parseNumber(std::string_view s, T &number) {
+    T parsed;
+    auto [end, error] = std::from_chars(s.data(), s.data() + s.size(), parsed);
+    if (error != std::errc() || end != s.data() + s.size())
+        return false;
+    number = parsed;
+    return true;
+}
+
 template <class T> class CyclingValues {
   private:
     std::vector<T> values;
@@ -35,6 +48,10 @@ template <class T> class CyclingValues {
     explicit CyclingValues(std::initializer_list<T> values,
                            std::size_t initialIndex = 0)
         : values(values), currentIndex(initialIndex) {}
+    template <class Range>
+    explicit CyclingValues(const Range &values, std::size_t initialIndex = 0)
+        : values(std::begin(values), std::end(values)),
+          currentIndex(initialIndex) {}
     [[nodiscard]] constexpr T current() const {
         return this->values[this->currentIndex];
     }
@@ -42,6 +59,14 @@ template <class T> class CyclingValues {
         this->currentIndex = (this->currentIndex + 1) % this->values.size();
         return this->current();
     }
+    // move to the given value, if it is one of the allowed ones
+    constexpr bool select(const T &value) {
+        auto it = std::find(this->values.begin(), this->values.end(), value);
+        if (it == this->values.end())
+            return false;
+        this->currentIndex = it - this->values.begin();
+        return true;
+    }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,47 @@
+#include "lib2048watch.hpp"
+#include <algorithm>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+fileWatcher::fileWatcher(const std::string &directory,
+                         std::vector<std::string> names)
+    : fd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)), names(std::move(names)) {
+    if (this->fd < 0)
+        return;
+    if (inotify_add_watch(this->fd, directory.c_str(),
+                          IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        close(this->fd);
+        this->fd = -1;
+    }
+}
+
+fileWatcher::~fileWatcher() {
+    if (this->fd >= 0)
+        close(this->fd);
+}
+
+bool fileWatcher::valid() const { return this->fd >= 0; }
+
+std::vector<std::string> fileWatcher::poll() {
+    std::vector<std::string> changed;
+    if (this->fd < 0)
+        return changed;
+
+    alignas(inotify_event) char buffer[4096];
+    ssize_t length;
+    while ((length = read(this->fd, buffer, sizeof(buffer))) > 0) {
+        for (char *cursor = buffer; cursor < buffer + length;) {
+            auto event = reinterpret_cast<inotify_event *>(cursor);
+            cursor += sizeof(inotify_event) + event->len;
+            if (!event->len)
+                continue;
+            std::string name(event->name);
+            if (std::find(this->names.begin(), this->names.end(), name) !=
+                    this->names.end() &&
+                std::find(changed.begin(), changed.end(), name) ==
+                    changed.end())
+                changed.push_back(name);
+        }
+    }
+    return changed;
+}
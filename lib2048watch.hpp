@@ -0,0 +1,29 @@
+#include <string>
+#include <vector>
+
+#ifndef _2048WATCH
+#define _2048WATCH
+
+/**
+ * Non-blocking inotify watch over a few files of a directory.
+ *
+ * The directory is watched rather than the files themselves, so that
+ * editors saving through a temporary file and a rename are noticed too.
+ */
+class fileWatcher {
+  public:
+    fileWatcher(const std::string &directory, std::vector<std::string> names);
+    fileWatcher(const fileWatcher &) = delete;
+    fileWatcher &operator=(const fileWatcher &) = delete;
+    ~fileWatcher();
+
+    bool valid() const;
+    // names of the watched files written to since the last call
+    std::vector<std::string> poll();
+
+  private:
+    int fd = -1;
+    std::vector<std::string> names;
+};
+
+#endif